@@ -8,28 +8,43 @@ from uvicorn import Config, Server
 
 from am4.utils.aircraft import Aircraft
 from am4.utils.airport import Airport
+from am4.utils.db import DemandProvider
 from am4.utils.db import init as utils_init
 from am4.utils.route import AircraftRoute, Route, RoutesSearch
+from am4.utils.scheduler import Scheduler, SchedulerRejectedException
+from am4.utils.store import CursorNotFoundException, ResultStore
 
 from ..config import cfg
+from ..db.models.route import PyACROptionsSortBy
 from .models import (
     FAPIReqACROptions,
     FAPIReqACSearchQuery,
     FAPIReqAPSearchQuery,
+    FAPIReqCursor,
+    FAPIReqFilter,
+    FAPIReqPageLimit,
+    FAPIReqPageOffset,
     FAPIReqUser,
     FAPIRespACRoute,
     FAPIRespACRouteFind,
+    FAPIRespACRouteFindPage,
     FAPIRespAircraft,
     FAPIRespAircraftNotFound,
     FAPIRespAirport,
     FAPIRespAirportNotFound,
+    FAPIRespCursorNotFound,
     FAPIRespRoute,
+    FAPIRespSearchRejected,
+    filter_to_core,
 )
 
 
 @asynccontextmanager
 async def lifespan(app: FastAPI):
-    utils_init()
+    utils_init(lazy_demand=cfg.api.LAZY_DEMAND, demand_cache_bytes=cfg.api.DEMAND_CACHE_MB << 20)
+    if (blocks := DemandProvider.Default().blocks) is not None:
+        hubs = [r.ap for r in Airport.search_many(cfg.api.DEMAND_WARM_HUBS) if r.ap.valid]
+        blocks.warm_up(hubs)
     yield
 
 
@@ -169,16 +184,21 @@ async def ac_route_info(
     }
 
 
+def construct_rejected_response(e: SchedulerRejectedException) -> ORJSONResponse:
+    return ORJSONResponse(status_code=503, content={"status": "rejected", "detail": str(e)})
+
+
 @app.get(
     "/ac_route/find",
     response_model=FAPIRespACRouteFind,
-    responses={404: {"model": FAPIRespAirportNotFound | FAPIRespAircraftNotFound}},
+    responses={404: {"model": FAPIRespAirportNotFound | FAPIRespAircraftNotFound}, 503: {"model": FAPIRespSearchRejected}},
 )
 async def ac_route_find_routes(
     ap0: FAPIReqAPSearchQuery,
     ac: FAPIReqACSearchQuery,
     options: Annotated[FAPIReqACROptions, Depends()],
     user: Annotated[FAPIReqUser, Depends()],
+    filter: FAPIReqFilter = None,
 ):
     apsr0 = Airport.search(ap0)
     if not apsr0.ap.valid:
@@ -187,15 +207,77 @@ async def ac_route_find_routes(
     if not acsr.ac.valid:
         return construct_acnf_response("ac", Aircraft.suggest(acsr.parse_result))
 
-    rs = RoutesSearch(apsr0.ap, acsr.ac, options.to_core(acsr.ac.type), user.to_core())
+    rs = RoutesSearch(apsr0.ap, acsr.ac, options.to_core(acsr.ac.type), user.to_core(), filter_to_core(filter))
+    try:
+        result = await asyncio.get_running_loop().run_in_executor(
+            None, Scheduler.Default().submit, rs, Scheduler.Priority.API, cfg.api.SEARCH_TIMEOUT
+        )
+    except SchedulerRejectedException as e:
+        return construct_rejected_response(e)
     return ORJSONResponse(
         content={
             "status": "success",
-            "destinations": [destination.to_dict() for destination in rs.get()],
+            "truncated": result.truncated,
+            "destinations": [destination.to_dict() for destination in result.destinations],
         }
     )
 
 
+@app.get(
+    "/ac_route/find_paged",
+    response_model=FAPIRespACRouteFindPage,
+    responses={404: {"model": FAPIRespAirportNotFound | FAPIRespAircraftNotFound}, 503: {"model": FAPIRespSearchRejected}},
+)
+async def ac_route_find_routes_paged(
+    ap0: FAPIReqAPSearchQuery,
+    ac: FAPIReqACSearchQuery,
+    options: Annotated[FAPIReqACROptions, Depends()],
+    user: Annotated[FAPIReqUser, Depends()],
+    limit: FAPIReqPageLimit = 50,
+    filter: FAPIReqFilter = None,
+):
+    apsr0 = Airport.search(ap0)
+    if not apsr0.ap.valid:
+        return construct_apnf_response("ap0", Airport.suggest(apsr0.parse_result))
+    acsr = Aircraft.search(ac)
+    if not acsr.ac.valid:
+        return construct_acnf_response("ac", Aircraft.suggest(acsr.parse_result))
+
+    rs = RoutesSearch(apsr0.ap, acsr.ac, options.to_core(acsr.ac.type), user.to_core(), filter_to_core(filter))
+    try:
+        page = await asyncio.get_running_loop().run_in_executor(
+            None, ResultStore.Default().search, rs, limit, Scheduler.Priority.API, cfg.api.SEARCH_TIMEOUT
+        )
+    except SchedulerRejectedException as e:
+        return construct_rejected_response(e)
+    return ORJSONResponse(content={"status": "success", **page.to_dict()})
+
+
+@app.get(
+    "/ac_route/page",
+    response_model=FAPIRespACRouteFindPage,
+    responses={404: {"model": FAPIRespCursorNotFound}},
+)
+async def ac_route_page(
+    cursor: FAPIReqCursor,
+    offset: FAPIReqPageOffset = 0,
+    limit: FAPIReqPageLimit = 50,
+    sort_by: PyACROptionsSortBy | None = None,
+):
+    try:
+        page = await asyncio.get_running_loop().run_in_executor(
+            None,
+            ResultStore.Default().page,
+            cursor,
+            offset,
+            limit,
+            AircraftRoute.Options.SortBy.__members__[sort_by] if sort_by is not None else None,
+        )
+    except CursorNotFoundException:
+        return ORJSONResponse(status_code=404, content={"status": "not_found", "parameter": "cursor"})
+    return ORJSONResponse(content={"status": "success", **page.to_dict()})
+
+
 server = Server(
     Config(
         app,
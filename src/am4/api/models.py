@@ -5,17 +5,20 @@ from pydantic import BaseModel, Field
 
 from am4.utils.aircraft import Aircraft
 from am4.utils.game import User
-from am4.utils.route import AircraftRoute
+from am4.utils.route import AircraftRoute, InvalidFilterException, RoutesSearch
 
 from ..common import (
     HELP_AC_ARG0,
+    HELP_ACRO_CI_OBJECTIVE,
     HELP_ACRO_CFG,
     HELP_ACRO_MAXDIST,
     HELP_ACRO_MAXFT,
+    HELP_ACRO_MINDIST,
     HELP_ACRO_SORTBY,
     HELP_ACRO_TPD,
     HELP_ACRO_TPD_MODE,
     HELP_AP_ARG0,
+    HELP_RS_FILTER,
     HELP_U_ACCUMULATED_COUNT,
     HELP_U_CO2_PRICE,
     HELP_U_CO2_TRAINING,
@@ -33,9 +36,11 @@ from ..db.models.aircraft import PyAircraft, PyAircraftSuggestion
 from ..db.models.airport import PyAirport, PyAirportSuggestion
 from ..db.models.game import PyUser
 from ..db.models.route import (
+    PyACROptionsCIObjective,
     PyACROptionsConfigAlgorithm,
     PyACROptionsMaxDistance,
     PyACROptionsMaxFlightTime,
+    PyACROptionsMinDistance,
     PyACROptionsSortBy,
     PyACROptionsTPDMode,
     PyACROptionsTripsPerDayPerAC,
@@ -95,9 +100,30 @@ class FAPIDestination(BaseModel):
 
 class FAPIRespACRouteFind(BaseModel):
     status: str = Field("success", frozen=True)
+    truncated: bool
     destinations: list[FAPIDestination]
 
 
+class FAPIRespACRouteFindPage(BaseModel):
+    status: str = Field("success", frozen=True)
+    cursor: str
+    offset: int
+    total: int
+    has_more: bool
+    truncated: bool
+    destinations: list[FAPIDestination]
+
+
+class FAPIRespCursorNotFound(BaseModel):
+    status: str = Field("not_found", frozen=True)
+    parameter: str = Field("cursor")
+
+
+class FAPIRespSearchRejected(BaseModel):
+    status: str = Field("rejected", frozen=True)
+    detail: str
+
+
 class FAPIRespRoute(BaseModel):
     status: str = Field("success", frozen=True)
     ap_origin: PyAirport
@@ -113,12 +139,40 @@ FAPIReqAPSearchQuery = Annotated[
     str,
     Query(description=HELP_AP_ARG0),
 ]
+FAPIReqPageLimit = Annotated[
+    int,
+    Query(ge=0, le=1000, description="[Optional] **Number of destinations per page** - defaults to `50`."),
+]
+FAPIReqPageOffset = Annotated[
+    int,
+    Query(ge=0, description="[Optional] **Index of the first destination to return** - defaults to `0`."),
+]
+FAPIReqCursor = Annotated[
+    str,
+    Query(description="**Cursor** returned by `/ac_route/find_paged`. Cursors expire when evicted from the cache."),
+]
+FAPIReqFilter = Annotated[
+    str | None,
+    Query(description=HELP_RS_FILTER),
+]
 FAPIReqRealism = Annotated[
     bool,
     Query(description="[Optional] **Whether to use realism mode** - defaults to `false` (easy) if not specified."),
 ]
 
 
+def filter_to_core(expr: str | None) -> RoutesSearch.Filter:
+    if expr is None:
+        return RoutesSearch.Filter()
+    try:
+        return RoutesSearch.Filter.parse(expr)
+    except InvalidFilterException as e:
+        raise HTTPException(
+            status_code=422,
+            detail=[{"loc": ["query", "filter"], "msg": str(e), "type": "value_error"}],
+        )
+
+
 class FAPIReqACROptions:
     # not using pydantic basemodel: see https://fastapi.tiangolo.com/tutorial/dependencies/classes-as-dependencies/#shortcut
     def __init__(
@@ -147,6 +201,14 @@ class FAPIReqACROptions:
             PyACROptionsSortBy,
             Query(description=HELP_ACRO_SORTBY),
         ] = None,
+        min_distance: Annotated[
+            PyACROptionsMinDistance,
+            Query(description=HELP_ACRO_MINDIST),
+        ] = None,
+        ci_objective: Annotated[
+            PyACROptionsCIObjective,
+            Query(description=HELP_ACRO_CI_OBJECTIVE),
+        ] = None,
     ):
         self.config_algorithm = config_algorithm
         self.max_distance = max_distance
@@ -154,6 +216,8 @@ class FAPIReqACROptions:
         self.tpd_mode = tpd_mode
         self.trips_per_day_per_ac = trips_per_day_per_ac
         self.sort_by = sort_by
+        self.min_distance = min_distance
+        self.ci_objective = ci_objective
 
     def to_core(self, ac_type: Aircraft.Type) -> AircraftRoute.Options:
         opt = {}
@@ -177,6 +241,8 @@ class FAPIReqACROptions:
             opt["config_algorithm"] = alg
         if self.max_distance is not None:
             opt["max_distance"] = self.max_distance
+        if self.min_distance is not None:
+            opt["min_distance"] = self.min_distance
         if self.max_flight_time is not None:
             opt["max_flight_time"] = self.max_flight_time
         if self.tpd_mode is not None:
@@ -220,6 +286,8 @@ class FAPIReqACROptions:
                     ],
                 )
             opt["sort_by"] = sb
+        if self.ci_objective is not None:
+            opt["ci_objective"] = AircraftRoute.Options.CIObjective.__members__[self.ci_objective]
         return AircraftRoute.Options(**opt)
 
 
@@ -12,8 +12,10 @@ from pyarrow import csv
 
 from am4.utils.aircraft import Aircraft
 from am4.utils.airport import Airport
+from am4.utils.fleet import FleetAllocator
 from am4.utils.game import User
 from am4.utils.route import AircraftRoute, Destination, RoutesSearch
+from am4.utils.scheduler import Scheduler
 
 from ...config import cfg
 from ..base import BaseCog
@@ -219,34 +221,36 @@ class RoutesCog(BaseCog):
 
         rs = RoutesSearch(ap_query.ap, ac_query.ac, options, u)
         t_start = time.time()
-        destinations: list[Destination] = await asyncio.get_event_loop().run_in_executor(self.executor, rs.get)
+        result = await asyncio.get_event_loop().run_in_executor(
+            self.executor, Scheduler.Default().submit, rs, Scheduler.Priority.INTERACTIVE, cfg.bot.SEARCH_TIMEOUT
+        )
+        destinations: list[Destination] = result.destinations
         t_end = time.time()
 
         embed = discord.Embed(
             title=format_ap_short(ap_query.ap, mode=0),
             colour=get_user_colour(u),
         )
-        profits = []  # each entry represents one aircraft
-        for i, d in enumerate(destinations):
-            acr = d.ac_route
-
-            profit_per_day_per_ac = acr.profit * acr.trips_per_day_per_ac
-            for _ in range(acr.num_ac):
-                profits.append(profit_per_day_per_ac)
-            if i > 2:
-                continue
-
+        for d in destinations[:3]:
             add_data(d, is_cargo, embed)
+        # profit added by each of the best 30 aircraft, accounting for the demand every extra aircraft uses up. 30
+        # aircraft never spread over more than 30 routes, so only the best ranked 30 are solved.
+        allocation = await asyncio.get_event_loop().run_in_executor(
+            self.executor, FleetAllocator(rs, 30).allocate, destinations[:30]
+        )
+        profits = allocation.marginal_profits
         if not destinations:
             embed.description = (
                 "There are no profitable routes found. Try relaxing the constraints or reducing the trips per day."
             )
 
         sorted_by = f" (sorted by $ {'per ac per day' if cons_set else 'per trip'})"
+        timed_out = ", timed out before searching every airport" if result.truncated else ""
         embed.set_footer(
             text=(
-                f"{len(destinations)} routes found in {(t_end-t_start)*1000:.2f} ms{sorted_by}\n"
-                f"top 10 ac: $ {sum(profits[:10]):,.0f}/d, 30 ac: $ {sum(profits[:30]):,.0f}/d\n"
+                f"{len(destinations)} routes found in {(t_end-t_start)*1000:.2f} ms{sorted_by}{timed_out}\n"
+                f"fleet over the top 30 routes (several ac may share a route): "
+                f"10 ac $ {sum(profits[:10]):,.0f}/d, 30 ac $ {sum(profits[:30]):,.0f}/d\n"
                 "Generating map and CSV..."
             ),
         )
@@ -348,6 +352,7 @@ class RoutesCog(BaseCog):
         await h.invalid_tpd()
         await h.invalid_cfg_alg()
         await h.invalid_constraint()
+        await h.search_rejected()
 
         await h.banned_user()
         await h.too_many_args("argument")
@@ -9,6 +9,7 @@ from rich.console import Console
 
 from am4.utils.aircraft import Aircraft
 from am4.utils.airport import Airport
+from am4.utils.scheduler import SchedulerRejectedException
 from am4.utils.db.utils import jaro_winkler_distance
 
 from ..config import cfg
@@ -237,6 +238,17 @@ class CustomErrHandler:
         await self.ctx.send(embed=embed)
         self.handled = True
 
+    async def search_rejected(self):
+        if not isinstance(getattr(self.error, "original", None), SchedulerRejectedException):
+            return
+        await self.ctx.send(
+            embed=self._get_err_embed(
+                title="I'm busy right now!",
+                description="Too many searches are running at the moment. Please try again in a little while.",
+            )
+        )
+        self.handled = True
+
     async def banned_user(self):
         if not isinstance(self.error, UserBannedError):
             return
@@ -174,6 +174,8 @@ def format_warning(w: AircraftRoute.Warning):
         return "Reduced contribution"
     elif w == AircraftRoute.Warning.ERR_DISTANCE_ABOVE_SPECIFIED:
         return "Distance above specified limit"
+    elif w == AircraftRoute.Warning.ERR_DISTANCE_BELOW_SPECIFIED:
+        return "Distance below specified limit"
     elif w == AircraftRoute.Warning.ERR_TRIPS_PER_DAY_TOO_HIGH:
         return "Trips per day per aircraft is too high"
     else:
@@ -16,6 +16,7 @@ HELP_ACRO_CFG = (
     "which selects the best order for that distance class."
 )
 HELP_ACRO_MAXDIST = "[Optional] **Maximum route distance (km)** - defaults to 6371π if not specified."
+HELP_ACRO_MINDIST = "[Optional] **Minimum route distance (km)** - defaults to 0 if not specified."
 HELP_ACRO_MAXFT = "[Optional] **Maximum flight time (h)** - defaults to 24 if not specified."
 HELP_ACRO_TPD_MODE = (
     "[Optional] **Trips per day mode**: one of `AUTO`, `STRICT_ALLOW_MULTIPLE_AC`, `STRICT`. If not specified, "
@@ -25,7 +26,20 @@ HELP_ACRO_TPD = (
     "[Optional] **Trips per day**: defaults to 1. Note that this parameter is only respected when tpd_mode is set "
     "to `STRICT_ALLOW_MULTIPLE_AC` or `STRICT`. When `tpd_mode=AUTO`, it throws an error."
 )
-HELP_ACRO_SORTBY = "[Optional] **Sort by**: one of `PER_AC_PER_DAY`, `PROFIT_PER_AC_PER_DAY`."
+HELP_ACRO_SORTBY = (
+    "[Optional] **Sort by**: one of `PER_TRIP` (default), `PER_AC_PER_DAY`, `PER_FLIGHT_HOUR`, "
+    "`CONTRIBUTION_PER_DAY`, `PER_SEAT`, `INCOME`, `PER_DAY_AFTER_HUB_COST` (hub cost amortised over 30 days), "
+    "`FLIGHT_TIME` (shortest first)."
+)
+HELP_ACRO_CI_OBJECTIVE = (
+    "[Optional] **Cost index optimisation**: one of `NONE` (default, always flies at CI 200), `PER_AC_PER_DAY` "
+    "(the CI that maximises profit per aircraft per day) or `CONTRIBUTION_PER_DAY`. A lower CI burns less fuel but "
+    "flies slower, which may reduce the trips per day."
+)
+HELP_RS_FILTER = (
+    "[Optional] **Destination filter**: `;`-separated clauses out of `continent=...`, `country=...`, `market>=...`, "
+    "`rwy>=...`, `hub_cost<=...` and `exclude=<airport ids>`, e.g. `continent=europe; market>=60; exclude=1,2`."
+)
 HELP_U_WEAR_TRAINING = "**Wear training** (default: `0`)"
 HELP_U_REPAIR_TRAINING = "**Repair training** (default: `0`)"
 HELP_U_L_TRAINING = "**L training** (default: `0`)"
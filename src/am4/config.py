@@ -17,6 +17,12 @@ class ConfigAPI(BaseModel):
     HOST: str = "0.0.0.0"
     PORT: int = 8002
     RELOAD: bool = False
+    LAZY_DEMAND: bool = False  # page the routes demand in per origin instead of loading all of it
+    DEMAND_CACHE_MB: int = 64
+    DEMAND_WARM_HUBS: list[str] = []  # airport queries whose demand is loaded at startup
+    # seconds a route search may take: a search that cannot start in time is rejected, one still running returns the
+    # routes it has so far
+    SEARCH_TIMEOUT: float | None = 20.0
 
 
 class ConfigBot(BaseModel):
@@ -31,6 +37,7 @@ class ConfigBot(BaseModel):
     MODERATOR_ROLEID: int
     HELPER_ROLEID: int
     SERVER_ID: int
+    SEARCH_TIMEOUT: float | None = 10.0
 
 
 class Config(BaseModel):
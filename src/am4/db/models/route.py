@@ -27,10 +27,21 @@ assert_equal_property_names(Route, PyRoute)
 
 PyACROptionsConfigAlgorithm = Literal[PyConfigAlgorithmPax, PyConfigAlgorithmCargo]
 PyACROptionsMaxDistance = Annotated[float, Field(gt=100, lt=65536)]
+PyACROptionsMinDistance = Annotated[float, Field(ge=0, lt=65536)]
 PyACROptionsMaxFlightTime = Annotated[float, Field(gt=0, lt=72)]
 PyACROptionsTPDMode = Literal["AUTO", "STRICT_ALLOW_MULTIPLE_AC", "STRICT"]
 PyACROptionsTripsPerDayPerAC = Annotated[int, Field(ge=1, lt=65536)]
-PyACROptionsSortBy = Literal["PER_TRIP", "PER_AC_PER_DAY"]
+PyACROptionsCIObjective = Literal["NONE", "PER_AC_PER_DAY", "CONTRIBUTION_PER_DAY"]
+PyACROptionsSortBy = Literal[
+    "PER_TRIP",
+    "PER_AC_PER_DAY",
+    "PER_FLIGHT_HOUR",
+    "CONTRIBUTION_PER_DAY",
+    "PER_SEAT",
+    "INCOME",
+    "PER_DAY_AFTER_HUB_COST",
+    "FLIGHT_TIME",
+]
 
 
 class PyACRouteStopover(BaseModel):
@@ -72,6 +83,7 @@ class PyACRoute(BaseModel):
             "ERR_FLIGHT_TIME_ABOVE_SPECIFIED",
             "ERR_INSUFFICIENT_DEMAND",
             "ERR_TRIPS_PER_DAY_TOO_HIGH",
+            "ERR_DISTANCE_BELOW_SPECIFIED",
         ]
     ]
     valid: Optional[bool]
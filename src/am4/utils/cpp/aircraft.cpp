@@ -1,35 +1,17 @@
 #include "include/aircraft.hpp"
 
 #include <algorithm>
+#include <charconv>
 #include <iostream>
 #include <string>
+#include <unordered_map>
 
 #include "include/db.hpp"
 #include "include/util.hpp"
 
 Aircraft::Aircraft() : speed_mod(false), fuel_mod(false), co2_mod(false), fourx_mod(false), valid(false) {}
 
-// removes trailing spaces or spaces that suceed commas in-place
-void remove_spaces_custom(string& str) {
-    bool space_found = false;
-    size_t len = str.length();
-
-    for (size_t i = 0; i < len; i++) {
-        if (str[i] == ' ' && ((i == 0 || i == len - 1 || str[i - 1] == ',') || space_found)) {
-            space_found = true;
-            str.erase(i, 1);
-            i--;
-            len--;
-        } else {
-            space_found = false;
-        }
-    }
-}
-
-Aircraft::ParseResult Aircraft::parse(const string& s) {
-    string s_lower = s;
-    std::transform(s_lower.begin(), s_lower.end(), s_lower.begin(), ::tolower);
-
+Aircraft::ParseResult Aircraft::parse(std::string_view s) {
     uint8_t priority = 0;
     bool speed_mod = false;
     bool fuel_mod = false;
@@ -38,102 +20,110 @@ Aircraft::ParseResult Aircraft::parse(const string& s) {
 
     // attempt to get modifiers, e.g. mc214[0,s,c,f] -> priority: true,
     // speed_mod: true, co2_mod: true, fuel_mod: true
-    size_t start = s_lower.find('[');
-    if (start != string::npos && s_lower.at(s_lower.size() - 1) == ']') {
-        string parsed = s_lower.substr(start + 1, s_lower.size() - start - 2);
-        remove_spaces_custom(parsed);
-        s_lower = s_lower.substr(0, start);
-
-        std::vector<string> tokens;
-        size_t last = 0, next = 0;
-        while ((next = parsed.find(',', last)) != string::npos) {
-            tokens.push_back(parsed.substr(last, next - last));
-            last = next + 1;
-        }
-        tokens.push_back(parsed.substr(last));
-
-        for (const string& token : tokens) {
+    const size_t start = s.find('[');
+    if (start != std::string_view::npos && s.back() == ']') {
+        std::string_view mods = s.substr(start + 1, s.size() - start - 2);
+        s = s.substr(0, start);
+        while (true) {
+            const size_t comma = mods.find(',');
+            const std::string_view token = trim_spaces(mods.substr(0, comma));
             if (token.length() <= 4) {
-                if (token.find('s') != string::npos) speed_mod = true;
-                if (token.find('f') != string::npos) fuel_mod = true;
-                if (token.find('c') != string::npos) co2_mod = true;
-                if (token.find('x') != string::npos) fourx_mod = true;
-            }
-            try {
-                if (priority == 0) priority = static_cast<uint8_t>(std::stoi(token));
-            } catch (const std::invalid_argument&) {
-            } catch (const std::out_of_range&) {
+                for (char c : token) {
+                    c = ascii_lower(c);
+                    if (c == 's') speed_mod = true;
+                    if (c == 'f') fuel_mod = true;
+                    if (c == 'c') co2_mod = true;
+                    if (c == 'x') fourx_mod = true;
+                }
             }
+            // a leading number is the engine priority, e.g. `1` or `1s`
+            if (priority == 0) std::from_chars(token.data(), token.data() + token.size(), priority);
+            if (comma == std::string_view::npos) break;
+            mods.remove_prefix(comma + 1);
         }
-        s_lower = s_lower.substr(0, start);
     }
-    if (s_lower.substr(0, 5) == "name:") {
-        return Aircraft::ParseResult(
-            Aircraft::SearchType::NAME, s_lower.substr(5), priority, speed_mod, fuel_mod, co2_mod, fourx_mod
-        );
-    } else if (s_lower.substr(0, 10) == "shortname:") {
+    auto result = [&](Aircraft::SearchType search_type, std::string_view search_str) {
         return Aircraft::ParseResult(
-            Aircraft::SearchType::SHORTNAME, s_lower.substr(10), priority, speed_mod, fuel_mod, co2_mod, fourx_mod
+            search_type, to_lower(search_str), priority, speed_mod, fuel_mod, co2_mod, fourx_mod
         );
-    } else if (s_lower.substr(0, 3) == "id:") {
+    };
+    if (starts_with_lower(s, "name:")) {
+        return result(Aircraft::SearchType::NAME, s.substr(5));
+    } else if (starts_with_lower(s, "shortname:")) {
+        return result(Aircraft::SearchType::SHORTNAME, s.substr(10));
+    } else if (starts_with_lower(s, "id:")) {
         uint16_t id;
-        if (str_to_uint16(s_lower.substr(3), id)) {
-            return Aircraft::ParseResult(
-                Aircraft::SearchType::ID, s_lower.substr(3), priority, speed_mod, fuel_mod, co2_mod, fourx_mod
-            );
-        }
-    } else if (s_lower.substr(0, 4) == "all:") {
-        return Aircraft::ParseResult(
-            Aircraft::SearchType::ALL, s_lower.substr(4), priority, speed_mod, fuel_mod, co2_mod, fourx_mod
-        );
+        if (str_to_uint16(s.substr(3), id)) return result(Aircraft::SearchType::ID, s.substr(3));
+    } else if (starts_with_lower(s, "all:")) {
+        return result(Aircraft::SearchType::ALL, s.substr(4));
     }
-    return Aircraft::ParseResult(Aircraft::SearchType::ALL, s_lower, priority, speed_mod, fuel_mod, co2_mod, fourx_mod);
+    return result(Aircraft::SearchType::ALL, s);
 }
 
-Aircraft::SearchResult Aircraft::search(const string& s, const User& user) {
+Aircraft::SearchResult Aircraft::search(std::string_view s, const User& user) {
     auto parse_result = Aircraft::parse(s);
-    Aircraft ac;
+    const auto& db = Database::Client();
+    uint16_t idx = AIRCRAFT_COUNT;
     switch (parse_result.search_type) {
         case Aircraft::SearchType::ALL:
-            ac = Database::Client()->get_aircraft_by_all(parse_result.search_str, parse_result.priority);
+            idx = db->find_aircraft_by_all(parse_result.search_str, parse_result.priority);
             break;
         case Aircraft::SearchType::NAME:
-            ac = Database::Client()->get_aircraft_by_name(parse_result.search_str, parse_result.priority);
+            idx = db->find_aircraft_by_name(parse_result.search_str, parse_result.priority);
             break;
         case Aircraft::SearchType::SHORTNAME:
-            ac = Database::Client()->get_aircraft_by_shortname(parse_result.search_str, parse_result.priority);
+            idx = db->find_aircraft_by_shortname(parse_result.search_str, parse_result.priority);
             break;
         case Aircraft::SearchType::ID:
             uint16_t id;
-            if (str_to_uint16(parse_result.search_str, id)) {
-                ac = Database::Client()->get_aircraft_by_id(id, parse_result.priority);
-            } else {
-                ac = Aircraft();
-            }
+            if (str_to_uint16(parse_result.search_str, id)) idx = db->find_aircraft_by_id(id, parse_result.priority);
             break;
     }
-    ac.speed_mod = parse_result.speed_mod;
-    if (ac.speed_mod) {
-        ac.speed *= 1.1f;
-        ac.cost *= 1.07f;
-    };
+    const bool fourx_mod = parse_result.fourx_mod || user.fourx;
+    if (idx == AIRCRAFT_COUNT) {
+        Aircraft ac;
+        ac.apply_mods(parse_result.speed_mod, parse_result.fuel_mod, parse_result.co2_mod, fourx_mod);
+        return Aircraft::SearchResult(make_shared<Aircraft>(ac), parse_result);
+    }
+    const uint8_t variant =
+        Aircraft::mods_variant(parse_result.speed_mod, parse_result.fuel_mod, parse_result.co2_mod, fourx_mod);
+    return Aircraft::SearchResult(make_shared<Aircraft>(db->aircraft_variants[idx][variant]), parse_result);
+}
 
-    ac.fuel_mod = parse_result.fuel_mod;
-    if (ac.fuel_mod) {
-        ac.fuel *= 0.9f;
-        ac.cost *= 1.10f;
+std::vector<Aircraft::SearchResult> Aircraft::search_many(
+    const std::vector<string>& queries, const User& user
+) {
+    std::vector<Aircraft::SearchResult> results;
+    results.reserve(queries.size());
+    std::unordered_map<std::string_view, size_t> seen;
+    for (const string& query : queries) {
+        auto [it, inserted] = seen.emplace(query, results.size());
+        results.push_back(inserted ? Aircraft::search(query, user) : results[it->second]);
+    }
+    return results;
+}
+
+void Aircraft::apply_mods(bool speed_mod, bool fuel_mod, bool co2_mod, bool fourx_mod) {
+    this->speed_mod = speed_mod;
+    if (this->speed_mod) {
+        this->speed *= 1.1f;
+        this->cost *= 1.07f;
     };
 
-    ac.co2_mod = parse_result.co2_mod;
-    if (ac.co2_mod) {
-        ac.co2 *= 0.9f;
-        ac.cost *= 1.05f;
+    this->fuel_mod = fuel_mod;
+    if (this->fuel_mod) {
+        this->fuel *= 0.9f;
+        this->cost *= 1.10f;
     };
 
-    ac.fourx_mod = parse_result.fourx_mod || user.fourx;
-    if (ac.fourx_mod) ac.speed *= 4.0f;
+    this->co2_mod = co2_mod;
+    if (this->co2_mod) {
+        this->co2 *= 0.9f;
+        this->cost *= 1.05f;
+    };
 
-    return Aircraft::SearchResult(make_shared<Aircraft>(ac), parse_result);
+    this->fourx_mod = fourx_mod;
+    if (this->fourx_mod) this->speed *= 4.0f;
 }
 
 std::vector<Aircraft::Suggestion> Aircraft::suggest(const ParseResult& parse_result) {
@@ -571,6 +561,11 @@ void pybind_init_aircraft(py::module_& m) {
         .def_static(
             "search", &Aircraft::search, "s"_a, py::arg_v("user", User::Default(), "am4.utils.game.User.Default()")
         )
+        .def_static(
+            "search_many", &Aircraft::search_many, "queries"_a,
+            py::arg_v("user", User::Default(), "am4.utils.game.User.Default()"),
+            py::call_guard<py::gil_scoped_release>()
+        )
         .def_static("suggest", &Aircraft::suggest, "s"_a);
 }
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <algorithm>
 #include <string>
+#include <unordered_map>
 
 #include "include/db.hpp"
 #include "include/airport.hpp"
@@ -9,58 +10,65 @@
 
 Airport::Airport() : valid(false) {}
 
-Airport::ParseResult Airport::parse(const string& s) {
-    string s_upper = s;
-    std::transform(s_upper.begin(), s_upper.end(), s_upper.begin(), ::toupper);
-
-    if (s_upper.substr(0, 5) == "IATA:") {
-        return ParseResult(SearchType::IATA, s_upper.substr(5));
-    } else if (s_upper.substr(0, 5) == "ICAO:") {
-        return Airport::ParseResult(SearchType::ICAO, s_upper.substr(5));
-    } else if (s_upper.substr(0, 5) == "NAME:") {
-        return ParseResult(SearchType::NAME, s_upper.substr(5));
-    } else if (s_upper.substr(0, 9) == "FULLNAME:") {
-        return ParseResult(SearchType::FULLNAME, s_upper.substr(9));
-    } else if (s_upper.substr(0, 3) == "ID:") {
+Airport::ParseResult Airport::parse(std::string_view s) {
+    if (starts_with_lower(s, "iata:")) {
+        return ParseResult(SearchType::IATA, to_upper(s.substr(5)));
+    } else if (starts_with_lower(s, "icao:")) {
+        return Airport::ParseResult(SearchType::ICAO, to_upper(s.substr(5)));
+    } else if (starts_with_lower(s, "name:")) {
+        return ParseResult(SearchType::NAME, to_upper(s.substr(5)));
+    } else if (starts_with_lower(s, "fullname:")) {
+        return ParseResult(SearchType::FULLNAME, to_upper(s.substr(9)));
+    } else if (starts_with_lower(s, "id:")) {
         uint16_t id;
         if (str_to_uint16(s.substr(3), id)) {
-            return ParseResult(SearchType::ID, s.substr(3));
+            return ParseResult(SearchType::ID, string(s.substr(3)));
         }
-    } else if (s_upper.substr(0, 4) == "ALL:") {
-        return ParseResult(SearchType::ALL, s_upper.substr(4));
+    } else if (starts_with_lower(s, "all:")) {
+        return ParseResult(SearchType::ALL, to_upper(s.substr(4)));
     }
-    return ParseResult(SearchType::ALL, s_upper);
+    return ParseResult(SearchType::ALL, to_upper(s));
 }
 
-Airport::SearchResult Airport::search(const string& s) {
+Airport::SearchResult Airport::search(std::string_view s) {
     auto parse_result = Airport::parse(s);
-    Airport ap;
+    const auto& db = Database::Client();
+    const string& search_str = parse_result.search_str;
+    uint16_t idx = AIRPORT_COUNT;
     switch (parse_result.search_type) {
         case SearchType::ALL:
-            ap = Database::Client()->get_airport_by_all(parse_result.search_str);
+            idx = db->find_airport_by_all(search_str);
             break;
         case SearchType::IATA:
-            ap = Database::Client()->get_airport_by_iata(parse_result.search_str);
+            idx = db->find_airport_by_iata(search_str);
             break;
         case SearchType::ICAO:
-            ap = Database::Client()->get_airport_by_icao(parse_result.search_str);
+            idx = db->find_airport_by_icao(search_str);
             break;
         case SearchType::NAME:
-            ap = Database::Client()->get_airport_by_name(parse_result.search_str);
+            idx = db->find_airport_by_name(search_str);
             break;
         case SearchType::FULLNAME:
-            ap = Database::Client()->get_airport_by_fullname(parse_result.search_str);
+            idx = db->find_airport_by_fullname(search_str);
             break;
         case SearchType::ID:
             uint16_t id;
-            if (str_to_uint16(parse_result.search_str, id)) {
-                ap = Database::Client()->get_airport_by_id(id);
-            } else {
-                ap = Airport();
-            }
+            if (str_to_uint16(search_str, id)) idx = db->find_airport_by_id(id);
             break;
     }
-    return SearchResult(make_shared<Airport>(ap), parse_result);
+    auto ap = idx == AIRPORT_COUNT ? make_shared<Airport>() : make_shared<Airport>(db->airports[idx]);
+    return SearchResult(ap, parse_result);
+}
+
+std::vector<Airport::SearchResult> Airport::search_many(const std::vector<string>& queries) {
+    std::vector<SearchResult> results;
+    results.reserve(queries.size());
+    std::unordered_map<std::string_view, size_t> seen;
+    for (const string& query : queries) {
+        auto [it, inserted] = seen.emplace(query, results.size());
+        results.push_back(inserted ? Airport::search(query) : results[it->second]);
+    }
+    return results;
 }
 
 // note: searchtype id will return no suggestions.
@@ -171,7 +179,7 @@ void pybind_init_airport(py::module_& m) {
         .value("ID", Airport::SearchType::ID);
 
     py::class_<Airport::ParseResult>(ap_class, "ParseResult")
-        .def(py::init<Airport::SearchType, const string&>())
+        .def(py::init<Airport::SearchType, string>())
         .def_readonly("search_type", &Airport::ParseResult::search_type)
         .def_readonly("search_str", &Airport::ParseResult::search_str);
 
@@ -185,6 +193,8 @@ void pybind_init_airport(py::module_& m) {
         .def_readonly("ap", &Airport::Suggestion::ap)
         .def_readonly("score", &Airport::Suggestion::score);
 
-    ap_class.def_static("search", &Airport::search, "s"_a).def_static("suggest", &Airport::suggest, "s"_a);
+    ap_class.def_static("search", &Airport::search, "s"_a)
+        .def_static("search_many", &Airport::search_many, "queries"_a, py::call_guard<py::gil_scoped_release>())
+        .def_static("suggest", &Airport::suggest, "s"_a);
 }
 #endif
\ No newline at end of file
@@ -8,6 +8,10 @@
 #include "include/airport.hpp"
 #include "include/aircraft.hpp"
 #include "include/route.hpp"
+#include "include/scheduler.hpp"
+#include "include/store.hpp"
+#include "include/fleet.hpp"
+#include "include/simulation.hpp"
 
 #include "include/log.hpp"
 
@@ -18,6 +22,10 @@ void pybind_init_demand(py::module_&);
 void pybind_init_airport(py::module_&);
 void pybind_init_aircraft(py::module_&);
 void pybind_init_route(py::module_&);
+void pybind_init_scheduler(py::module_&);
+void pybind_init_store(py::module_&);
+void pybind_init_fleet(py::module_&);
+void pybind_init_simulation(py::module_&);
 void pybind_init_log(py::module_&);
 
 PYBIND11_MODULE(utils, m) {
@@ -28,6 +36,10 @@ PYBIND11_MODULE(utils, m) {
     pybind_init_airport(m);
     pybind_init_aircraft(m);
     pybind_init_route(m);
+    pybind_init_scheduler(m);
+    pybind_init_store(m);
+    pybind_init_fleet(m);
+    pybind_init_simulation(m);
     pybind_init_log(m);
 
 #ifdef VERSION_INFO
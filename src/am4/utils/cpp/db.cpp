@@ -2,6 +2,7 @@
 #include <string>
 #include <algorithm>
 #include <queue>
+#include <stdexcept>
 
 #include "include/db.hpp"
 #include "include/ext/jaro.hpp"
@@ -30,7 +31,7 @@ void Database::populate_database() {
     // std::cout << "removed!" << std::endl;
 }
 
-void Database::populate_internal() {
+void Database::populate_internal(bool lazy_demand, size_t demand_cache_bytes) {
     auto result = connection->Query("SELECT * FROM read_parquet('~/data/airports.parquet');");
     CHECK_SUCCESS_REF(result);
     idx_t i = 0;
@@ -53,6 +54,7 @@ void Database::populate_internal() {
         offset++;
         start_bp = bp + 1;
     }
+    build_airport_columns();
 
     result = connection->Query("SELECT * FROM read_parquet('~/data/aircrafts.parquet');");
     CHECK_SUCCESS_REF(result);
@@ -62,84 +64,441 @@ void Database::populate_internal() {
             aircrafts[i] = Aircraft(chunk, j);
         }
     }
-
-    result = connection->Query("SELECT yd, jd, fd, d FROM read_parquet('~/data/routes.parquet');");
+    build_aircraft_variants();
+
+    if (lazy_demand) {
+        pax_demands.reset();
+        demand_provider.use_blocks(std::make_unique<DemandBlockCache>(*connection, demand_cache_bytes));
+    } else {
+        pax_demands = std::make_unique<PaxDemand[]>(ROUTE_COUNT);
+        demand_provider.use_table(pax_demands.get());
+    }
+    // the distances are always loaded: a lazy demand only skips the demand columns
+    result = connection->Query(
+        lazy_demand ? "SELECT d FROM read_parquet('~/data/routes.parquet');"
+                    : "SELECT d, yd, jd, fd FROM read_parquet('~/data/routes.parquet');"
+    );
     CHECK_SUCCESS_REF(result);
     i = 0;
     uint16_t x = 0, y = 0;
     while (auto chunk = result->Fetch()) {
         for (idx_t j = 0; j < chunk->size(); j++, i++) {
-            pax_demands[i] = PaxDemand(
-                chunk->GetValue(0, j).GetValue<uint16_t>(), chunk->GetValue(1, j).GetValue<uint16_t>(),
-                chunk->GetValue(2, j).GetValue<uint16_t>()
-            );
+            if (!lazy_demand) {
+                pax_demands[i] = PaxDemand(
+                    chunk->GetValue(1, j).GetValue<uint16_t>(), chunk->GetValue(2, j).GetValue<uint16_t>(),
+                    chunk->GetValue(3, j).GetValue<uint16_t>()
+                );
+            }
             y++;
             if (y == AIRPORT_COUNT) {
                 x++;
                 y = x + 1;
             }
-            const double distance = chunk->GetValue(3, j).GetValue<double>();
+            const double distance = chunk->GetValue(0, j).GetValue<double>();
             distances[x][y] = distance;
             distances[y][x] = distance;
         }
     }
 }
 
+void Database::build_aircraft_variants() {
+    for (uint16_t i = 0; i < AIRCRAFT_COUNT; i++) {
+        for (uint8_t v = 0; v < Aircraft::MODS_VARIANTS; v++) {
+            Aircraft& ac = aircraft_variants[i][v] = aircrafts[i];
+            ac.apply_mods(v & 1, v & 2, v & 4, v & 8);
+        }
+    }
+}
+
+void Database::build_airport_columns() {
+    AirportColumns& c = airport_columns;
+    auto encode = [](std::vector<string>& names, const string& name) {
+        auto it = std::find(names.begin(), names.end(), name);
+        if (it != names.end()) return static_cast<size_t>(it - names.begin());
+        names.push_back(name);
+        return names.size() - 1;
+    };
+    c.continent_names.clear();
+    c.country_names.clear();
+    for (uint16_t i = 0; i < AIRPORT_COUNT; i++) {
+        const Airport& ap = airports[i];
+        c.id[i] = ap.id;
+        c.rwy[i] = ap.rwy;
+        c.lat[i] = ap.lat;
+        c.lng[i] = ap.lng;
+        c.market[i] = ap.market;
+        c.hub_cost[i] = ap.hub_cost;
+        c.continent[i] = static_cast<uint8_t>(encode(c.continent_names, ap.continent));
+        c.country[i] = static_cast<uint16_t>(encode(c.country_names, ap.country));
+    }
+}
+
+const std::vector<uint16_t>& Database::get_neighbours(uint16_t o_idx) {
+    std::call_once(neighbours_built[o_idx], [&] {
+        std::vector<uint16_t>& n = neighbours[o_idx];
+        n.reserve(AIRPORT_COUNT - 1);
+        for (uint16_t idx = 0; idx < AIRPORT_COUNT; idx++) {
+            if (idx != o_idx) n.push_back(idx);
+        }
+        const double* d = distances[o_idx];
+        std::sort(n.begin(), n.end(), [d](uint16_t a, uint16_t b) { return d[a] < d[b] || (d[a] == d[b] && a < b); });
+    });
+    return neighbours[o_idx];
+}
+
+std::pair<uint16_t, uint16_t> Database::get_dbroute_airports(uint32_t route_idx) {
+    // the last row starting at or before `route_idx`
+    uint16_t lo = 0, hi = AIRPORT_COUNT - 2;
+    while (lo < hi) {
+        const uint16_t mid = static_cast<uint16_t>((lo + hi + 1) / 2);
+        if (get_dbroute_idx(mid, mid + 1) <= route_idx) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return {lo, static_cast<uint16_t>(route_idx - get_dbroute_idx(lo, lo + 1) + lo + 1)};
+}
+
+std::atomic<uint64_t> DemandBlockCache::last_id{0};
+
+double DemandBlockCache::Stats::hit_rate() const {
+    const uint64_t total = hits + faults;
+    return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+}
+
+DemandBlockCache::DemandBlockCache(Connection& connection, size_t capacity_bytes)
+    : capacity_bytes(capacity_bytes),
+      max_blocks(std::max(size_t(1), capacity_bytes / BLOCK_BYTES)),
+      id(++last_id),
+      connection(connection),
+      hits(0),
+      faults(0),
+      evictions(0) {}
+
+PaxDemand DemandBlockCache::get(uint16_t o_idx, uint16_t d_idx) {
+    // a search reads the demand of one origin thousands of times in a row. the block stays alive while the thread
+    // holds it, even if it is evicted in the meantime.
+    thread_local struct {
+        uint64_t cache_id = 0;
+        uint16_t o_idx = 0;
+        shared_ptr<const Block> block;
+    } last;
+    if (last.cache_id != id || last.o_idx != o_idx || !last.block) {
+        last.block = block(o_idx);
+        last.cache_id = id;
+        last.o_idx = o_idx;
+    }
+    return (*last.block)[d_idx];
+}
+
+shared_ptr<const DemandBlockCache::Block> DemandBlockCache::block(uint16_t o_idx) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (blocks[o_idx]) {
+            hits++;
+            lru.splice(lru.begin(), lru, lru_pos[o_idx]);
+            return blocks[o_idx];
+        }
+    }
+    shared_ptr<const Block> b = fetch({o_idx})[0];
+    std::lock_guard<std::mutex> lock(mtx);
+    if (blocks[o_idx]) {  // another thread faulted it in first: served from the cache after all
+        hits++;
+        return blocks[o_idx];
+    }
+    faults++;
+    insert(o_idx, b);
+    return b;
+}
+
+bool DemandBlockCache::contains(uint16_t o_idx) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return blocks[o_idx] != nullptr;
+}
+
+size_t DemandBlockCache::warm_up(const std::vector<uint16_t>& o_idxs) {
+    std::vector<uint16_t> missing;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (uint16_t o_idx : o_idxs) {
+            if (o_idx >= AIRPORT_COUNT)
+                throw std::out_of_range("airport index " + std::to_string(o_idx) + " out of range");
+            if (!blocks[o_idx] && std::find(missing.begin(), missing.end(), o_idx) == missing.end())
+                missing.push_back(o_idx);
+        }
+    }
+    if (missing.empty()) return 0;
+    const auto fetched = fetch(missing);
+    std::lock_guard<std::mutex> lock(mtx);
+    for (size_t i = 0; i < missing.size(); i++) {
+        if (!blocks[missing[i]]) insert(missing[i], fetched[i]);
+    }
+    return missing.size();
+}
+
+/*
+routes.parquet is sorted by pair, so the row of every pair is known up front: the pairs of an origin are the contiguous
+run starting at (o_idx, o_idx + 1), plus one row in the run of each earlier airport. the filter only reads
+file_row_number, and one query serves any number of origins, so warming up several hubs costs a single scan.
+*/
+std::vector<shared_ptr<DemandBlockCache::Block>> DemandBlockCache::fetch(const std::vector<uint16_t>& o_idxs) const {
+    std::vector<shared_ptr<Block>> fetched(o_idxs.size());
+    int32_t slot[AIRPORT_COUNT];
+    std::fill(std::begin(slot), std::end(slot), -1);
+    string where;
+    for (size_t i = 0; i < o_idxs.size(); i++) {
+        const uint16_t o = o_idxs[i];
+        fetched[i] = make_shared<Block>();
+        slot[o] = static_cast<int32_t>(i);
+        const string first = std::to_string(o + 1 < AIRPORT_COUNT ? Database::get_dbroute_idx(o, o + 1) : ROUTE_COUNT);
+        const string count = std::to_string(AIRPORT_COUNT - o - 1);
+        if (!where.empty()) where += " OR ";
+        where += "(file_row_number >= " + first + " AND file_row_number < " + first + " + " + count +
+                 ") OR file_row_number IN (SELECT (o * (2 * " + std::to_string(AIRPORT_COUNT) + " - o - 1)) // 2 + " +
+                 std::to_string(o) + " - o - 1 FROM range(" + std::to_string(o) + ") t(o))";
+    }
+    auto result = connection.Query(
+        "SELECT file_row_number, yd, jd, fd FROM read_parquet('~/data/routes.parquet', file_row_number = true) "
+        "WHERE " +
+        where + ";"
+    );
+    CHECK_SUCCESS_REF(result);
+    while (auto chunk = result->Fetch()) {
+        for (idx_t j = 0; j < chunk->size(); j++) {
+            const uint32_t route_idx = static_cast<uint32_t>(chunk->GetValue(0, j).GetValue<int64_t>());
+            const auto [a, b] = Database::get_dbroute_airports(route_idx);
+            const PaxDemand pd(
+                chunk->GetValue(1, j).GetValue<uint16_t>(), chunk->GetValue(2, j).GetValue<uint16_t>(),
+                chunk->GetValue(3, j).GetValue<uint16_t>()
+            );
+            if (slot[a] != -1) (*fetched[slot[a]])[b] = pd;
+            if (slot[b] != -1) (*fetched[slot[b]])[a] = pd;
+        }
+    }
+    return fetched;
+}
+
+void DemandBlockCache::insert(uint16_t o_idx, shared_ptr<const Block> block) {
+    lru.push_front(o_idx);
+    lru_pos[o_idx] = lru.begin();
+    blocks[o_idx] = std::move(block);
+    while (lru.size() > max_blocks) {
+        blocks[lru.back()] = nullptr;
+        lru.pop_back();
+        evictions++;
+    }
+}
+
+DemandBlockCache::Stats DemandBlockCache::stats() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    Stats s;
+    s.hits = hits;
+    s.faults = faults;
+    s.evictions = evictions;
+    s.blocks = lru.size();
+    s.bytes = s.blocks * BLOCK_BYTES;
+    return s;
+}
+
+void DemandBlockCache::reset_stats() {
+    hits = 0;
+    faults = 0;
+    evictions = 0;
+}
+
+void DemandBlockCache::clear() {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (uint16_t o_idx : lru) blocks[o_idx] = nullptr;
+    lru.clear();
+}
+
+DemandProvider::DemandProvider(size_t capacity)
+    : capacity(std::max(size_t(1), capacity)), table(nullptr), last_version(0) {}
+
+void DemandProvider::use_table(const PaxDemand* table) {
+    this->table = table;
+    block_cache.reset();
+}
+
+void DemandProvider::use_blocks(std::unique_ptr<DemandBlockCache> blocks) {
+    table = nullptr;
+    block_cache = std::move(blocks);
+}
+
+DemandBlockCache* DemandProvider::blocks() const { return block_cache.get(); }
+
+PaxDemand DemandProvider::get(uint32_t route_idx, const DemandLayer* layer) const {
+    if (table) return layer ? layer->get(route_idx, table[route_idx]) : table[route_idx];
+    const auto [a, b] = Database::get_dbroute_airports(route_idx);
+    return get(a, b, layer);
+}
+
+PaxDemand DemandProvider::get(uint16_t o_idx, uint16_t d_idx, const DemandLayer* layer) const {
+    const uint32_t route_idx = Database::get_dbroute_idx(o_idx, d_idx);
+    PaxDemand base;  // before the database is populated
+    if (table) {
+        base = table[route_idx];
+    } else if (block_cache) {
+        base = block_cache->get(o_idx, d_idx);
+    }
+    return layer ? layer->get(route_idx, base) : base;
+}
+
+shared_ptr<const DemandLayer> DemandProvider::layer(const string& key) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = layers.find(key);
+    if (it == layers.end()) return nullptr;
+    lru.splice(lru.begin(), lru, it->second.second);
+    return it->second.first;
+}
+
+// copy-on-write: a search that already holds the previous snapshot keeps reading it
+void DemandProvider::publish(const string& key, shared_ptr<DemandLayer> layer) {
+    layer->key = key;
+    layer->version = ++last_version;
+    auto it = layers.find(key);
+    if (it != layers.end()) {
+        it->second.first = layer;
+        lru.splice(lru.begin(), lru, it->second.second);
+        return;
+    }
+    lru.push_front(key);
+    layers.emplace(key, std::make_pair(layer, lru.begin()));
+    while (layers.size() > capacity) {
+        layers.erase(lru.back());
+        lru.pop_back();
+    }
+}
+
+void DemandProvider::set(const string& key, const std::vector<std::pair<uint32_t, PaxDemand>>& overrides) {
+    for (const auto& o : overrides) {
+        if (o.first >= ROUTE_COUNT) throw std::out_of_range("route index " + std::to_string(o.first) + " out of range");
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = layers.find(key);
+    auto layer = it == layers.end() ? make_shared<DemandLayer>() : make_shared<DemandLayer>(*it->second.first);
+    for (const auto& [route_idx, demand] : overrides) layer->overrides[route_idx] = demand;
+    publish(key, layer);
+}
+
+void DemandProvider::set(const string& key, const Airport& a0, const Airport& a1, const PaxDemand& demand) {
+    if (a0.id == a1.id) throw std::invalid_argument("the origin and destination must differ");
+    const auto& db = Database::Client();
+    const uint32_t route_idx =
+        Database::get_dbroute_idx(db->airport_id_hashtable[a0.id], db->airport_id_hashtable[a1.id]);
+    set(key, {{route_idx, demand}});
+}
+
+bool DemandProvider::unset(const string& key, uint32_t route_idx) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = layers.find(key);
+    if (it == layers.end() || it->second.first->overrides.count(route_idx) == 0) return false;
+    auto layer = make_shared<DemandLayer>(*it->second.first);
+    layer->overrides.erase(route_idx);
+    publish(key, layer);
+    return true;
+}
+
+bool DemandProvider::erase(const string& key) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = layers.find(key);
+    if (it == layers.end()) return false;
+    lru.erase(it->second.second);
+    layers.erase(it);
+    return true;
+}
+
+size_t DemandProvider::size() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return layers.size();
+}
+
 const uint16_t missing_apids[] = {52,   178,  248,  318,  538,  542,  544,  552,  558,  562,  571,  572,  577,
                                   597,  1110, 1130, 1162, 1200, 1249, 1265, 1306, 1310, 1311, 1313, 1326, 1328,
                                   1356, 1358, 1378, 1381, 1388, 1391, 1468, 1481, 1513, 1528, 1532, 1537, 1540,
                                   1542, 1543, 1571, 1592, 1598, 1625, 1683, 1696, 2382, 2400, 2533, 2557, 2559,
                                   2566, 2573, 2577, 2591, 2597, 2610, 2627, 2630, 2647, 2648, 2656, 2660, 2662,
                                   2664, 2666, 2667, 2673, 3053, 3194, 3507, 3508, 3550, 3899};
-Airport Database::get_airport_by_id(uint16_t id) {
-    if (std::find(std::begin(missing_apids), std::end(missing_apids), id) != std::end(missing_apids)) return Airport();
-    if (id > 3982) return Airport();
-    return airports[airport_id_hashtable[id]];
+uint16_t Database::find_airport_by_id(uint16_t id) {
+    if (std::find(std::begin(missing_apids), std::end(missing_apids), id) != std::end(missing_apids))
+        return AIRPORT_COUNT;
+    if (id > 3982) return AIRPORT_COUNT;
+    return airport_id_hashtable[id];
+}
+
+// `name` is "NAME, COUNTRY", uppercased. compared in place, without building the airport's full name
+inline bool fullname_equals(const Airport& a, std::string_view name) {
+    if (name.size() != a.name.size() + 2 + a.country.size()) return false;
+    return equals_folded<true>(a.name, name.substr(0, a.name.size())) && name.substr(a.name.size(), 2) == ", " &&
+           equals_folded<true>(a.country, name.substr(a.name.size() + 2));
 }
 
 // TODO: use unordered_map or gperf instead of linear search
-Airport Database::get_airport_by_iata(const string& iata) {
+uint16_t Database::find_airport_by_iata(std::string_view iata) {
     auto it = std::find_if(std::begin(airports), std::end(airports), [&](const Airport& a) { return a.iata == iata; });
-    return it == std::end(airports) ? Airport() : *it;
+    return static_cast<uint16_t>(it - std::begin(airports));
 }
 
-Airport Database::get_airport_by_icao(const string& icao) {
+uint16_t Database::find_airport_by_icao(std::string_view icao) {
     auto it = std::find_if(std::begin(airports), std::end(airports), [&](const Airport& a) { return a.icao == icao; });
-    return it == std::end(airports) ? Airport() : *it;
+    return static_cast<uint16_t>(it - std::begin(airports));
 }
 
-Airport Database::get_airport_by_name(const string& name) {
+uint16_t Database::find_airport_by_name(std::string_view name) {
     auto it = std::find_if(std::begin(airports), std::end(airports), [&](const Airport& a) {
-        string db_name = a.name;
-        std::transform(db_name.begin(), db_name.end(), db_name.begin(), ::toupper);
-        return db_name == name;
+        return equals_folded<true>(a.name, name);
     });
-    return it == std::end(airports) ? Airport() : *it;
+    return static_cast<uint16_t>(it - std::begin(airports));
 }
 
-Airport Database::get_airport_by_fullname(const string& name) {
+uint16_t Database::find_airport_by_fullname(std::string_view name) {
     auto it = std::find_if(std::begin(airports), std::end(airports), [&](const Airport& a) {
-        string db_fullname = a.name + ", " + a.country;
-        std::transform(db_fullname.begin(), db_fullname.end(), db_fullname.begin(), ::toupper);
-        return db_fullname == name;
+        return fullname_equals(a, name);
     });
-    return it == std::end(airports) ? Airport() : *it;
+    return static_cast<uint16_t>(it - std::begin(airports));
 }
 
-Airport Database::get_airport_by_all(const string& all) {
+uint16_t Database::find_airport_by_all(std::string_view all) {
     uint16_t id;
     if (str_to_uint16(all, id)) {
-        Airport ap = get_airport_by_id(id);
-        if (ap.valid) return ap;
+        const uint16_t idx = find_airport_by_id(id);
+        if (idx != AIRPORT_COUNT && airports[idx].valid) return idx;
     }
     auto it = std::find_if(std::begin(airports), std::end(airports), [&](const Airport& a) {
-        string db_name = a.name;
-        std::transform(db_name.begin(), db_name.end(), db_name.begin(), ::toupper);
-        string db_fullname = db_name + ", " + a.country;
-        std::transform(db_fullname.begin(), db_fullname.end(), db_fullname.begin(), ::toupper);
-        return a.iata == all || a.icao == all || db_name == all || db_fullname == all;
+        return a.iata == all || a.icao == all || equals_folded<true>(a.name, all) || fullname_equals(a, all);
     });
-    return it == std::end(airports) ? Airport() : *it;
+    return static_cast<uint16_t>(it - std::begin(airports));
+}
+
+Airport Database::get_airport_by_id(uint16_t id) {
+    const uint16_t idx = find_airport_by_id(id);
+    return idx == AIRPORT_COUNT ? Airport() : airports[idx];
+}
+
+Airport Database::get_airport_by_iata(std::string_view iata) {
+    const uint16_t idx = find_airport_by_iata(iata);
+    return idx == AIRPORT_COUNT ? Airport() : airports[idx];
+}
+
+Airport Database::get_airport_by_icao(std::string_view icao) {
+    const uint16_t idx = find_airport_by_icao(icao);
+    return idx == AIRPORT_COUNT ? Airport() : airports[idx];
+}
+
+Airport Database::get_airport_by_name(std::string_view name) {
+    const uint16_t idx = find_airport_by_name(name);
+    return idx == AIRPORT_COUNT ? Airport() : airports[idx];
+}
+
+Airport Database::get_airport_by_fullname(std::string_view name) {
+    const uint16_t idx = find_airport_by_fullname(name);
+    return idx == AIRPORT_COUNT ? Airport() : airports[idx];
+}
+
+Airport Database::get_airport_by_all(std::string_view all) {
+    const uint16_t idx = find_airport_by_all(all);
+    return idx == AIRPORT_COUNT ? Airport() : airports[idx];
 }
 
 template <typename ScoreFn>
@@ -257,40 +616,57 @@ uint16_t Database::get_aircraft_idx_by_id(uint16_t id, uint8_t priority) {
 const uint16_t missing_acids[] = {54,  57,  65,  70,  77,  78,  79,  80,  81,  82,  83,  84,  88,  98,  121, 122,
                                   123, 125, 174, 175, 176, 188, 217, 223, 224, 225, 235, 236, 237, 238, 239, 240,
                                   261, 262, 263, 264, 265, 278, 279, 280, 286, 296, 297, 301, 319, 354};
-Aircraft Database::get_aircraft_by_id(uint16_t id, uint8_t priority) {
-    if (std::find(std::begin(missing_acids), std::end(missing_acids), id) != std::end(missing_acids)) return Aircraft();
-    if (id > 375) return Aircraft();
-    return aircrafts[Database::get_aircraft_idx_by_id(id, priority)];
+uint16_t Database::find_aircraft_by_id(uint16_t id, uint8_t priority) {
+    if (std::find(std::begin(missing_acids), std::end(missing_acids), id) != std::end(missing_acids))
+        return AIRCRAFT_COUNT;
+    if (id > 375) return AIRCRAFT_COUNT;
+    return Database::get_aircraft_idx_by_id(id, priority);
 }
 
-Aircraft Database::get_aircraft_by_shortname(const string& shortname, uint8_t priority) {
+uint16_t Database::find_aircraft_by_shortname(std::string_view shortname, uint8_t priority) {
     auto it = std::find_if(std::begin(aircrafts), std::end(aircrafts), [&](const Aircraft& a) {
         return a.shortname == shortname && a.priority == priority;
     });
-    return it == std::end(aircrafts) ? Aircraft() : *it;
+    return static_cast<uint16_t>(it - std::begin(aircrafts));
 }
 
-Aircraft Database::get_aircraft_by_name(const string& name, uint8_t priority) {
+uint16_t Database::find_aircraft_by_name(std::string_view name, uint8_t priority) {
     auto it = std::find_if(std::begin(aircrafts), std::end(aircrafts), [&](const Aircraft& a) {
-        string db_name = a.name;
-        std::transform(db_name.begin(), db_name.end(), db_name.begin(), ::tolower);
-        return db_name == name && a.priority == priority;
+        return a.priority == priority && equals_folded<false>(a.name, name);
     });
-    return it == std::end(aircrafts) ? Aircraft() : *it;
+    return static_cast<uint16_t>(it - std::begin(aircrafts));
 }
 
-Aircraft Database::get_aircraft_by_all(const string& shortname, uint8_t priority) {
+uint16_t Database::find_aircraft_by_all(std::string_view shortname, uint8_t priority) {
     uint16_t id;
     if (str_to_uint16(shortname, id)) {
-        Aircraft ac = get_aircraft_by_id(id, 0);
-        if (ac.valid) return ac;
+        const uint16_t idx = find_aircraft_by_id(id, 0);
+        if (idx != AIRCRAFT_COUNT && aircrafts[idx].valid) return idx;
     }
     auto it = std::find_if(std::begin(aircrafts), std::end(aircrafts), [&](const Aircraft& a) {
-        string db_name = a.name;
-        std::transform(db_name.begin(), db_name.end(), db_name.begin(), ::tolower);
-        return (a.shortname == shortname || db_name == shortname) && a.priority == priority;
+        return a.priority == priority && (a.shortname == shortname || equals_folded<false>(a.name, shortname));
     });
-    return it == std::end(aircrafts) ? Aircraft() : *it;
+    return static_cast<uint16_t>(it - std::begin(aircrafts));
+}
+
+Aircraft Database::get_aircraft_by_id(uint16_t id, uint8_t priority) {
+    const uint16_t idx = find_aircraft_by_id(id, priority);
+    return idx == AIRCRAFT_COUNT ? Aircraft() : aircrafts[idx];
+}
+
+Aircraft Database::get_aircraft_by_shortname(std::string_view shortname, uint8_t priority) {
+    const uint16_t idx = find_aircraft_by_shortname(shortname, priority);
+    return idx == AIRCRAFT_COUNT ? Aircraft() : aircrafts[idx];
+}
+
+Aircraft Database::get_aircraft_by_name(std::string_view name, uint8_t priority) {
+    const uint16_t idx = find_aircraft_by_name(name, priority);
+    return idx == AIRCRAFT_COUNT ? Aircraft() : aircrafts[idx];
+}
+
+Aircraft Database::get_aircraft_by_all(std::string_view all, uint8_t priority) {
+    const uint16_t idx = find_aircraft_by_all(all, priority);
+    return idx == AIRCRAFT_COUNT ? Aircraft() : aircrafts[idx];
 }
 
 template <typename ScoreFn>
@@ -336,9 +712,9 @@ std::vector<Aircraft::Suggestion> Database::suggest_aircraft_by_all(const string
     });
 }
 
-void init(string home_dir) {
+void init(string home_dir, bool lazy_demand, size_t demand_cache_bytes) {
     auto client = Database::Client(home_dir);
-    client->populate_internal();
+    client->populate_internal(lazy_demand, demand_cache_bytes);
     client->populate_database();
 }
 
@@ -362,7 +738,7 @@ void pybind_init_db(py::module_& m) {
 
     m_db.def(
             "init",
-            [](std::optional<string> home_dir) {
+            [](std::optional<string> home_dir, bool lazy_demand, size_t demand_cache_bytes) {
                 py::gil_scoped_acquire acquire;
                 if (!home_dir.has_value()) {
                     string hdir = py::module::import("am4")
@@ -383,13 +759,14 @@ void pybind_init_db(py::module_& m) {
                             );
                         }
                     }
-                    init(hdir);
+                    init(hdir, lazy_demand, demand_cache_bytes);
                 } else {
-                    init(home_dir.value());
+                    init(home_dir.value(), lazy_demand, demand_cache_bytes);
                 }
                 py::gil_scoped_release release;
             },
-            "home_dir"_a = py::none()
+            "home_dir"_a = py::none(), "lazy_demand"_a = false,
+            "demand_cache_bytes"_a = DemandBlockCache::DEFAULT_CAPACITY_BYTES
     )
         .def("_debug_query", &_debug_query, "query"_a);
 
@@ -398,5 +775,83 @@ void pybind_init_db(py::module_& m) {
         .def("jaro_winkler_distance", &jaro_winkler_distance, "a"_a, "b"_a);
 
     py::register_exception<DatabaseException>(m_db, "DatabaseException");
+
+    py::class_<DemandLayer, shared_ptr<DemandLayer>>(m_db, "DemandLayer")
+        .def_readonly("key", &DemandLayer::key)
+        .def_readonly("version", &DemandLayer::version)
+        .def_readonly("overrides", &DemandLayer::overrides)
+        .def("get", &DemandLayer::get, "route_idx"_a, "base"_a)
+        .def("__len__", [](const DemandLayer& l) { return l.overrides.size(); });
+
+    auto to_airport_idx = [](const Airport& ap) {
+        if (!ap.valid) throw std::invalid_argument("invalid airport");
+        return Database::Client()->airport_id_hashtable[ap.id];
+    };
+
+    py::class_<DemandBlockCache> dbc_class(m_db, "DemandBlockCache");
+    py::class_<DemandBlockCache::Stats>(dbc_class, "Stats")
+        .def_readonly("hits", &DemandBlockCache::Stats::hits)
+        .def_readonly("faults", &DemandBlockCache::Stats::faults)
+        .def_readonly("evictions", &DemandBlockCache::Stats::evictions)
+        .def_readonly("blocks", &DemandBlockCache::Stats::blocks)
+        .def_readonly("bytes", &DemandBlockCache::Stats::bytes)
+        .def_property_readonly("hit_rate", &DemandBlockCache::Stats::hit_rate);
+    dbc_class.def_readonly_static("BLOCK_BYTES", &DemandBlockCache::BLOCK_BYTES)
+        .def_readonly("capacity_bytes", &DemandBlockCache::capacity_bytes)
+        .def_readonly("max_blocks", &DemandBlockCache::max_blocks)
+        .def(
+            "contains",
+            [to_airport_idx](const DemandBlockCache& c, const Airport& ap) { return c.contains(to_airport_idx(ap)); },
+            "ap"_a
+        )
+        .def(
+            "warm_up",
+            [to_airport_idx](DemandBlockCache& c, const std::vector<Airport>& hubs) {
+                std::vector<uint16_t> o_idxs;
+                o_idxs.reserve(hubs.size());
+                for (const Airport& ap : hubs) o_idxs.push_back(to_airport_idx(ap));
+                py::gil_scoped_release release;
+                return c.warm_up(o_idxs);
+            },
+            "hubs"_a
+        )
+        .def("stats", &DemandBlockCache::stats)
+        .def("reset_stats", &DemandBlockCache::reset_stats)
+        .def("clear", &DemandBlockCache::clear);
+
+    py::class_<DemandProvider>(m_db, "DemandProvider")
+        .def_static(
+            "Default", []() -> DemandProvider& { return Database::Client()->demand_provider; },
+            py::return_value_policy::reference
+        )
+        .def_readonly("capacity", &DemandProvider::capacity)
+        .def_property_readonly("blocks", &DemandProvider::blocks, py::return_value_policy::reference)
+        .def(
+            "get",
+            [](const DemandProvider& p, uint32_t route_idx, shared_ptr<DemandLayer> layer) {
+                if (route_idx >= ROUTE_COUNT) throw py::index_error("route index out of range");
+                py::gil_scoped_release release;  // may fault in a block
+                return p.get(route_idx, layer.get());
+            },
+            "route_idx"_a, "layer"_a = py::none()
+        )
+        .def(
+            "layer",
+            [](DemandProvider& p, const string& key) { return std::const_pointer_cast<DemandLayer>(p.layer(key)); },
+            "key"_a
+        )
+        .def(
+            "set",
+            py::overload_cast<const string&, const std::vector<std::pair<uint32_t, PaxDemand>>&>(&DemandProvider::set),
+            "key"_a, "overrides"_a
+        )
+        .def(
+            "set",
+            py::overload_cast<const string&, const Airport&, const Airport&, const PaxDemand&>(&DemandProvider::set),
+            "key"_a, "ap0"_a, "ap1"_a, "demand"_a
+        )
+        .def("unset", &DemandProvider::unset, "key"_a, "route_idx"_a)
+        .def("erase", &DemandProvider::erase, "key"_a)
+        .def("__len__", &DemandProvider::size);
 }
 #endif
\ No newline at end of file
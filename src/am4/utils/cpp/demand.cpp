@@ -24,6 +24,11 @@ CargoDemand CargoDemand::operator/(double load) const {
     );
 }
 
+PaxDemand DemandLayer::get(uint32_t route_idx, const PaxDemand& base) const {
+    auto it = overrides.find(route_idx);
+    return it == overrides.end() ? base : it->second;
+}
+
 const string PaxDemand::repr(const PaxDemand& demand) {
     return "<PaxDemand " + to_string(demand.y) + "|" + to_string(demand.j) + "|" + to_string(demand.f) + ">";
 }
@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+#include "include/fleet.hpp"
+#include "include/db.hpp"
+
+using TPDPoint = AircraftRoute::TPDPoint;
+
+inline double per_day(const TPDPoint& p) { return p.profit * p.trips_per_day_per_ac * p.num_ac; }
+inline double per_day(const AircraftRoute& ar) { return ar.profit * ar.trips_per_day_per_ac * ar.num_ac; }
+
+// the route as flown by the allocated aircraft
+inline void apply(AircraftRoute& ar, const TPDPoint& p, const User& user) {
+    ar.num_ac = p.num_ac;
+    ar.config = p.config;
+    ar.income = p.income;
+    ar.max_income = p.income / user.load;
+    ar.co2 = p.co2;
+    ar.profit = p.profit;
+}
+
+FleetAllocator::FleetAllocator(const RoutesSearch& search, uint16_t fleet_size, std::optional<double> budget)
+    : search(search), fleet_size(fleet_size), budget(budget) {}
+
+uint16_t FleetAllocator::max_num_ac() const {
+    if (!this->budget.has_value() || this->search.aircraft.cost <= 0) return this->fleet_size;
+    const double affordable = std::max(0., floor(this->budget.value() / this->search.aircraft.cost));
+    return static_cast<uint16_t>(std::min(affordable, static_cast<double>(this->fleet_size)));
+}
+
+FleetAllocator::Plan FleetAllocator::allocate() const { return this->allocate(this->search.get()); }
+
+/*
+Lazy greedy: the queue holds, for every route, the profit per day its next aircraft would add. Popping the best one
+assigns the aircraft and solves the route's config for one more aircraft against the same demand, so only about
+(routes + aircraft) configs are solved in total. A route flown by n aircraft makes n * tpd * the profit per trip of the
+config for n * tpd trips a day. Routes drop out once their demand can't fill another aircraft, and the allocation stops
+as soon as no aircraft adds any profit.
+*/
+FleetAllocator::Plan FleetAllocator::allocate(const vector<Destination>& destinations) const {
+    struct Gain {
+        double gain;
+        size_t route;
+        TPDPoint point;
+    };
+    // ties go to the route ranked first by the search
+    auto cmp = [](const Gain& a, const Gain& b) { return a.gain < b.gain || (a.gain == b.gain && a.route > b.route); };
+    std::priority_queue<Gain, vector<Gain>, decltype(cmp)> queue(cmp);
+
+    vector<std::optional<TPDPoint>> allocated(destinations.size());
+    auto push_next = [&](size_t route, uint16_t num_ac) {
+        const auto next = AircraftRoute::with_num_ac(
+            destinations[route].ac_route, this->search.aircraft, num_ac, this->search.options, this->search.user
+        );
+        if (!next.has_value()) return;
+        const double current = allocated[route].has_value() ? per_day(allocated[route].value()) : 0.;
+        queue.push({per_day(next.value()) - current, route, next.value()});
+    };
+    for (size_t route = 0; route < destinations.size(); route++) push_next(route, 1);
+
+    Plan plan;
+    const uint16_t max_num_ac = this->max_num_ac();
+    while (plan.num_ac < max_num_ac && !queue.empty()) {
+        const Gain best = queue.top();
+        if (best.gain <= 0) break;
+        queue.pop();
+        allocated[best.route] = best.point;
+        plan.num_ac++;
+        plan.profit_per_day += best.gain;
+        plan.marginal_profits.push_back(best.gain);
+        if (best.point.num_ac < std::numeric_limits<uint16_t>::max())
+            push_next(best.route, static_cast<uint16_t>(best.point.num_ac + 1));
+    }
+    plan.aircraft_cost = static_cast<double>(plan.num_ac) * this->search.aircraft.cost;
+
+    for (size_t route = 0; route < destinations.size(); route++) {
+        if (!allocated[route].has_value()) continue;
+        Destination d = destinations[route];
+        apply(d.ac_route, allocated[route].value(), this->search.user);
+        plan.destinations.push_back(d);
+    }
+    // stable, so routes with equal profit keep the search's order
+    auto ranks_before = [](const Destination& a, const Destination& b) {
+        return per_day(a.ac_route) > per_day(b.ac_route);
+    };
+    std::stable_sort(plan.destinations.begin(), plan.destinations.end(), ranks_before);
+    return plan;
+}
+
+NetworkPlanner::NetworkPlanner(
+    const vector<Airport>& hubs,
+    const vector<FleetEntry>& fleet,
+    const AircraftRoute::Options& options,
+    const User& user,
+    uint16_t threads
+)
+    : hubs(hubs), fleet(fleet), options(options), user(user), threads(threads) {}
+
+/*
+Pax and VIP routes share the pax demand of a pair, cargo routes the cargo demand. Both are tracked in pax demand
+units (cargo converts back through CargoDemand(PaxDemand): 1 y per 500 lbs large, 1 j per 1000 lbs heavy) as the
+daily passengers or cargo the allocated aircraft actually carry.
+*/
+inline std::array<double, 3> demand_used(const TPDPoint& p, const Aircraft& ac, const User& user) {
+    const double trips = static_cast<double>(p.trips_per_day_per_ac) * p.num_ac * user.load;
+    if (ac.type == Aircraft::Type::CARGO) {
+        const auto& cfg = std::get<Aircraft::CargoConfig>(p.config);
+        const double capacity = static_cast<double>(ac.capacity);
+        const double l = cfg.l / 100.0 * capacity * 0.7 * (1 + user.l_training / 100.0) * trips;
+        const double h = cfg.h / 100.0 * capacity * (1 + user.h_training / 100.0) * trips;
+        return {l / 500.0, h / 1000.0, 0};
+    }
+    const auto& cfg = std::get<Aircraft::PaxConfig>(p.config);
+    return {cfg.y * trips, cfg.j * trips, cfg.f * trips};
+}
+
+/*
+Greedy over (hub, aircraft, destination) lanes, as in FleetAllocator::allocate(), with two differences:
+- each fleet entry has its own aircraft count, and a lane is skipped once its entry has none left;
+- lanes on the same pool see each other's demand use. Every queued gain remembers the version of its pool, and a gain
+  that is popped after the pool changed is solved again against the current leftover demand and requeued.
+*/
+NetworkPlanner::Plan NetworkPlanner::plan(const CancellationToken& token) const {
+    const auto& db = Database::Client();
+    const size_t fleet_size = this->fleet.size();
+    const size_t jobs = this->hubs.size() * fleet_size;
+
+    struct Lane {
+        size_t job;
+        const Destination* destination;
+        uint32_t pool;
+        uint16_t num_ac;
+        std::optional<TPDPoint> point;
+        std::array<double, 3> used;
+    };
+    struct Pool {
+        PaxDemand demand;
+        std::array<double, 3> used;
+        uint32_t version;
+    };
+    vector<vector<Destination>> found(jobs);
+    vector<uint8_t> truncated(jobs, 0);
+
+    // the searches themselves are independent, so they're spread over the threads first
+    parallel_for(jobs, this->threads, [&](size_t job) {
+        const RoutesSearch rs(
+            this->hubs[job / fleet_size], this->fleet[job % fleet_size].aircraft, this->options, this->user
+        );
+        RoutesSearch::Result result = rs.run(token);
+        found[job] = std::move(result.destinations);
+        truncated[job] = result.truncated;
+    });
+
+    vector<Lane> lanes;
+    vector<Pool> pools;
+    std::unordered_map<uint64_t, uint32_t> pool_idxs;
+    for (size_t job = 0; job < jobs; job++) {
+        const uint16_t o_idx = db->airport_id_hashtable[this->hubs[job / fleet_size].id];
+        const bool cargo = this->fleet[job % fleet_size].aircraft.type == Aircraft::Type::CARGO;
+        for (const Destination& d : found[job]) {
+            const uint32_t pair = Database::get_dbroute_idx(o_idx, db->airport_id_hashtable[d.airport.id]);
+            const uint64_t key = static_cast<uint64_t>(pair) * 2 + cargo;
+            auto [it, inserted] = pool_idxs.emplace(key, static_cast<uint32_t>(pools.size()));
+            // the route's demand is what the options' demand overlay leaves of the pair
+            if (inserted) pools.push_back({d.ac_route.route.pax_demand, {0, 0, 0}, 0});
+            lanes.push_back({job, &d, it->second, 0, std::nullopt, {0, 0, 0}});
+        }
+    }
+
+    // the pair's demand less what every other lane on it carries
+    auto leftover = [&](const Lane& lane) {
+        const Pool& pool = pools[lane.pool];
+        const double demand[3] = {
+            static_cast<double>(pool.demand.y), static_cast<double>(pool.demand.j), static_cast<double>(pool.demand.f)
+        };
+        uint16_t left[3];
+        for (size_t c = 0; c < 3; c++) {
+            left[c] = static_cast<uint16_t>(std::max(0., floor(demand[c] - (pool.used[c] - lane.used[c]))));
+        }
+        return PaxDemand(left[0], left[1], left[2]);
+    };
+
+    struct Gain {
+        double gain;
+        uint32_t lane;
+        uint32_t version;
+        TPDPoint point;
+    };
+    auto cmp = [](const Gain& a, const Gain& b) { return a.gain < b.gain || (a.gain == b.gain && a.lane > b.lane); };
+    std::priority_queue<Gain, vector<Gain>, decltype(cmp)> queue(cmp);
+    auto push_next = [&](uint32_t l) {
+        const Lane& lane = lanes[l];
+        if (lane.num_ac == std::numeric_limits<uint16_t>::max()) return;
+        AircraftRoute ar = lane.destination->ac_route;
+        ar.route.pax_demand = leftover(lane);
+        const Aircraft& ac = this->fleet[lane.job % fleet_size].aircraft;
+        const auto next =
+            AircraftRoute::with_num_ac(ar, ac, static_cast<uint16_t>(lane.num_ac + 1), this->options, this->user);
+        if (!next.has_value()) return;
+        const double current = lane.point.has_value() ? per_day(lane.point.value()) : 0.;
+        queue.push({per_day(next.value()) - current, l, pools[lane.pool].version, next.value()});
+    };
+    for (uint32_t l = 0; l < lanes.size(); l++) push_next(l);
+
+    Plan plan;
+    plan.num_ac.assign(fleet_size, 0);
+    plan.truncated = std::any_of(truncated.begin(), truncated.end(), [](uint8_t t) { return t != 0; });
+    size_t left = 0;
+    for (const FleetEntry& f : this->fleet) left += f.count;
+    while (left > 0 && !queue.empty()) {
+        const Gain best = queue.top();
+        queue.pop();
+        Lane& lane = lanes[best.lane];
+        const size_t f = lane.job % fleet_size;
+        if (plan.num_ac[f] == this->fleet[f].count) continue;  // this entry is used up: drop its lanes
+        Pool& pool = pools[lane.pool];
+        if (best.version != pool.version) {
+            push_next(best.lane);
+            continue;
+        }
+        if (best.gain <= 0) break;
+
+        const auto used = demand_used(best.point, this->fleet[f].aircraft, this->user);
+        for (size_t c = 0; c < 3; c++) pool.used[c] += used[c] - lane.used[c];
+        pool.version++;
+        lane.used = used;
+        lane.point = best.point;
+        lane.num_ac++;
+        plan.num_ac[f]++;
+        plan.profit_per_day += best.gain;
+        plan.marginal_profits.push_back(best.gain);
+        left--;
+        push_next(best.lane);
+    }
+
+    for (const Lane& lane : lanes) {
+        if (lane.num_ac == 0) continue;
+        const uint16_t f = static_cast<uint16_t>(lane.job % fleet_size);
+        Assignment a{this->hubs[lane.job / fleet_size], f, *lane.destination};
+        apply(a.destination.ac_route, lane.point.value(), this->user);
+        plan.assignments.push_back(a);
+    }
+    std::stable_sort(plan.assignments.begin(), plan.assignments.end(), [](const Assignment& a, const Assignment& b) {
+        return per_day(a.destination.ac_route) > per_day(b.destination.ac_route);
+    });
+    return plan;
+}
+
+#if BUILD_PYBIND == 1
+#include "include/binder.hpp"
+
+py::dict to_dict(const FleetAllocator::Plan& p) {
+    py::list destinations;
+    for (const Destination& d : p.destinations) destinations.append(to_dict(d));
+    return py::dict(
+        "destinations"_a = destinations, "marginal_profits"_a = p.marginal_profits, "num_ac"_a = p.num_ac,
+        "profit_per_day"_a = p.profit_per_day, "aircraft_cost"_a = p.aircraft_cost
+    );
+}
+
+py::dict to_dict(const NetworkPlanner::Plan& p) {
+    py::list assignments;
+    for (const NetworkPlanner::Assignment& a : p.assignments) {
+        assignments.append(py::dict(
+            "hub"_a = to_dict(a.hub), "fleet_idx"_a = a.fleet_idx, "destination"_a = to_dict(a.destination)
+        ));
+    }
+    return py::dict(
+        "assignments"_a = assignments, "marginal_profits"_a = p.marginal_profits, "num_ac"_a = p.num_ac,
+        "profit_per_day"_a = p.profit_per_day, "truncated"_a = p.truncated
+    );
+}
+
+void pybind_init_fleet(py::module_& m) {
+    py::module_ m_fleet = m.def_submodule("fleet");
+
+    py::class_<FleetAllocator> fa_class(m_fleet, "FleetAllocator");
+    py::class_<FleetAllocator::Plan>(fa_class, "Plan")
+        .def_readonly("destinations", &FleetAllocator::Plan::destinations)
+        .def_readonly("marginal_profits", &FleetAllocator::Plan::marginal_profits)
+        .def_readonly("num_ac", &FleetAllocator::Plan::num_ac)
+        .def_readonly("profit_per_day", &FleetAllocator::Plan::profit_per_day)
+        .def_readonly("aircraft_cost", &FleetAllocator::Plan::aircraft_cost)
+        .def("to_dict", py::overload_cast<const FleetAllocator::Plan&>(&to_dict));
+
+    fa_class
+        .def(
+            py::init<const RoutesSearch&, uint16_t, std::optional<double>>(), "search"_a, "fleet_size"_a,
+            "budget"_a = py::none()
+        )
+        .def_readonly("search", &FleetAllocator::search)
+        .def_readonly("fleet_size", &FleetAllocator::fleet_size)
+        .def_readonly("budget", &FleetAllocator::budget)
+        .def("max_num_ac", &FleetAllocator::max_num_ac)
+        .def(
+            "allocate", py::overload_cast<>(&FleetAllocator::allocate, py::const_),
+            py::call_guard<py::gil_scoped_release>()
+        )
+        .def(
+            "allocate", py::overload_cast<const vector<Destination>&>(&FleetAllocator::allocate, py::const_),
+            "destinations"_a, py::call_guard<py::gil_scoped_release>()
+        );
+
+    py::class_<NetworkPlanner> np_class(m_fleet, "NetworkPlanner");
+    py::class_<NetworkPlanner::FleetEntry>(np_class, "FleetEntry")
+        .def(py::init<const Aircraft&, uint16_t>(), "aircraft"_a, "count"_a)
+        .def_readonly("aircraft", &NetworkPlanner::FleetEntry::aircraft)
+        .def_readonly("count", &NetworkPlanner::FleetEntry::count);
+    py::class_<NetworkPlanner::Assignment>(np_class, "Assignment")
+        .def_readonly("hub", &NetworkPlanner::Assignment::hub)
+        .def_readonly("fleet_idx", &NetworkPlanner::Assignment::fleet_idx)
+        .def_readonly("destination", &NetworkPlanner::Assignment::destination);
+    py::class_<NetworkPlanner::Plan>(np_class, "Plan")
+        .def_readonly("assignments", &NetworkPlanner::Plan::assignments)
+        .def_readonly("marginal_profits", &NetworkPlanner::Plan::marginal_profits)
+        .def_readonly("num_ac", &NetworkPlanner::Plan::num_ac)
+        .def_readonly("profit_per_day", &NetworkPlanner::Plan::profit_per_day)
+        .def_readonly("truncated", &NetworkPlanner::Plan::truncated)
+        .def("to_dict", py::overload_cast<const NetworkPlanner::Plan&>(&to_dict));
+
+    np_class
+        .def(
+            py::init<
+                const vector<Airport>&, const vector<NetworkPlanner::FleetEntry>&, const AircraftRoute::Options&,
+                const User&, uint16_t>(),
+            "hubs"_a, "fleet"_a,
+            py::arg_v("options", AircraftRoute::Options(), "am4.utils.route.AircraftRoute.Options()"),
+            py::arg_v("user", User::Default(), "am4.utils.game.User.Default()"), "threads"_a = 0
+        )
+        .def_readonly("hubs", &NetworkPlanner::hubs)
+        .def_readonly("fleet", &NetworkPlanner::fleet)
+        .def_readonly("options", &NetworkPlanner::options)
+        .def_readonly("user", &NetworkPlanner::user)
+        .def_readonly("threads", &NetworkPlanner::threads)
+        .def(
+            "plan", &NetworkPlanner::plan,
+            py::arg_v("token", CancellationToken(), "am4.utils.route.CancellationToken()"),
+            py::call_guard<py::gil_scoped_release>()
+        );
+}
+#endif
@@ -172,6 +172,32 @@ double Campaign::_estimate_eco_reputation(Eco eco) {
     return 0;
 }
 
+// the enum values encode the tier and the duration: C3_8HR = 32 is tier 3, 2 * 4 hours
+uint8_t Campaign::_duration(Airline airline) { return static_cast<uint8_t>(static_cast<uint8_t>(airline) % 10 * 4); }
+uint8_t Campaign::_duration(Eco eco) { return static_cast<uint8_t>(static_cast<uint8_t>(eco) % 10 * 4); }
+
+double Campaign::_estimate_airline_cost(Airline airline, uint16_t planes) {
+    const double hours = _duration(airline);
+    switch (static_cast<uint8_t>(airline) / 10) {
+        case 1:
+            return (2625 * hours + 4500) * planes;
+        case 2:
+            return (3937.5 * hours + 6750) * planes;
+        case 3:
+            return (4987.5 * hours + 8550) * planes;
+        case 4:
+            return (6037.5 * hours + 10350) * planes;
+    }
+    return 0;
+}
+
+double Campaign::_estimate_eco_cost(Eco eco, uint16_t planes) { return eco == Eco::NONE ? 0 : 8270.0 * planes; }
+
+double Campaign::estimate_cost(uint16_t planes) const {
+    return _estimate_airline_cost(pax_activated, planes) + _estimate_airline_cost(cargo_activated, planes) +
+           _estimate_eco_cost(eco_activated, planes);
+}
+
 bool Campaign::_set(const string &s) {
     if (s == "C1") {
         pax_activated = Airline::C1_24HR;
@@ -330,12 +356,19 @@ void pybind_init_game(py::module_ &m) {
         .value("C_20HR", Campaign::Eco::C_20HR)
         .value("C_24HR", Campaign::Eco::C_24HR)
         .value("NONE", Campaign::Eco::NONE);
-    campaign_class.def_readonly("pax_activated", &Campaign::pax_activated)
+    campaign_class
+        .def(
+            py::init<Campaign::Airline, Campaign::Airline, Campaign::Eco>(),
+            "pax_activated"_a = Campaign::Airline::NONE, "cargo_activated"_a = Campaign::Airline::NONE,
+            "eco_activated"_a = Campaign::Eco::NONE
+        )
+        .def_readonly("pax_activated", &Campaign::pax_activated)
         .def_readonly("cargo_activated", &Campaign::cargo_activated)
         .def_readonly("eco_activated", &Campaign::eco_activated)
         .def_static("Default", &Campaign::Default)
         .def_static("parse", &Campaign::parse, "s"_a)
         .def("estimate_pax_reputation", &Campaign::estimate_pax_reputation, "base_reputation"_a = 45)
-        .def("estimate_cargo_reputation", &Campaign::estimate_cargo_reputation, "base_reputation"_a = 45);
+        .def("estimate_cargo_reputation", &Campaign::estimate_cargo_reputation, "base_reputation"_a = 45)
+        .def("estimate_cost", &Campaign::estimate_cost, "planes"_a);
 }
 #endif
\ No newline at end of file
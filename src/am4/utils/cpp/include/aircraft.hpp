@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <map>
 #include <cstdint>
 #include <iomanip>
@@ -127,7 +128,7 @@ struct Aircraft {
 
         ParseResult(
             Aircraft::SearchType search_type,
-            const string& search_str,
+            string search_str,
             uint8_t priority,
             bool speed_mod,
             bool fuel_mod,
@@ -135,7 +136,7 @@ struct Aircraft {
             bool fourx_mod
         )
             : search_type(search_type),
-              search_str(search_str),
+              search_str(std::move(search_str)),
               priority(priority),
               speed_mod(speed_mod),
               fuel_mod(fuel_mod),
@@ -160,8 +161,19 @@ struct Aircraft {
     };
 
     Aircraft();
-    static ParseResult parse(const string& s);
-    static SearchResult search(const string& s, const User& user = User::Default());
+    // applies the engine mods (and their price increase) to a base aircraft
+    void apply_mods(bool speed_mod, bool fuel_mod, bool co2_mod, bool fourx_mod);
+    static constexpr uint8_t MODS_VARIANTS = 16;
+    static constexpr uint8_t mods_variant(bool speed_mod, bool fuel_mod, bool co2_mod, bool fourx_mod) {
+        return static_cast<uint8_t>(speed_mod | fuel_mod << 1 | co2_mod << 2 | fourx_mod << 3);
+    }
+    static ParseResult parse(std::string_view s);
+    static SearchResult search(std::string_view s, const User& user = User::Default());
+    // search() over many queries at once, e.g. a route list import: repeated queries are resolved once and share
+    // their result
+    static std::vector<SearchResult> search_many(
+        const std::vector<string>& queries, const User& user = User::Default()
+    );
     static std::vector<Aircraft::Suggestion> suggest(const ParseResult& parse_result);
 
     Aircraft(const duckdb::unique_ptr<duckdb::DataChunk>& chunk, idx_t row);
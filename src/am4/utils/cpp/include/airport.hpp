@@ -1,6 +1,8 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <vector>
 #include <memory>
 #include <duckdb.hpp>
 
@@ -38,8 +40,8 @@ struct Airport {
         Airport::SearchType search_type;
         string search_str;
 
-        ParseResult(Airport::SearchType search_type, const string& search_str)
-            : search_type(search_type), search_str(search_str) {}
+        ParseResult(Airport::SearchType search_type, string search_str)
+            : search_type(search_type), search_str(std::move(search_str)) {}
     };
 
     struct SearchResult {
@@ -58,8 +60,11 @@ struct Airport {
     };
 
     Airport();
-    static ParseResult parse(const string& s);
-    static SearchResult search(const string& s);
+    static ParseResult parse(std::string_view s);
+    static SearchResult search(std::string_view s);
+    // search() over many queries at once, e.g. a route list import: repeated queries are resolved once and share
+    // their result
+    static std::vector<SearchResult> search_many(const std::vector<string>& queries);
     static std::vector<Airport::Suggestion> suggest(const ParseResult& parse_result);
 
     Airport(const duckdb::unique_ptr<duckdb::DataChunk>& chunk, idx_t row);
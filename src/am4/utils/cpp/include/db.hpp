@@ -1,5 +1,12 @@
 #pragma once
 #include <duckdb.hpp>
+#include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include "airport.hpp"
 #include "aircraft.hpp"
@@ -43,6 +50,99 @@ inline void VERIFY_UPDATE_SUCCESS(duckdb::unique_ptr<T> q) {
     if (!result || result->size() != 1) throw DatabaseException("FATAL: cannot update user!");
 }
 
+// the game's demand when it is not loaded as a whole: one block per origin, holding its demand to every airport, read
+// from routes.parquet on first touch and kept in an LRU of at most `capacity_bytes`. a pair's demand is stored in the
+// blocks of both its airports, so a search only ever faults in the block of its origin.
+class DemandBlockCache {
+   public:
+    using Block = std::array<PaxDemand, AIRPORT_COUNT>;  // by destination index
+    static constexpr size_t BLOCK_BYTES = sizeof(Block);  // 23,442 B
+    static constexpr size_t DEFAULT_CAPACITY_BYTES = 64 << 20;
+
+    // block requests, not pair lookups: consecutive lookups from the same origin on one thread reuse its block
+    struct Stats {
+        uint64_t hits;    // lookups answered by a cached block, also when another thread fetched it meanwhile
+        uint64_t faults;  // blocks read from the file into the cache
+        uint64_t evictions;
+        size_t blocks;  // currently cached
+        size_t bytes;
+
+        double hit_rate() const;
+    };
+
+    const size_t capacity_bytes;
+    const size_t max_blocks;
+
+    DemandBlockCache(Connection& connection, size_t capacity_bytes = DEFAULT_CAPACITY_BYTES);
+
+    PaxDemand get(uint16_t o_idx, uint16_t d_idx);
+    // faults the block in if it is not cached, marks it as recently used otherwise
+    shared_ptr<const Block> block(uint16_t o_idx);
+    bool contains(uint16_t o_idx) const;
+    // loads the blocks of known busy origins (e.g. popular hubs) in one query. returns the number of blocks read
+    size_t warm_up(const std::vector<uint16_t>& o_idxs);
+    Stats stats() const;
+    void reset_stats();
+    void clear();
+
+   private:
+    static std::atomic<uint64_t> last_id;
+    const uint64_t id;  // tells apart the thread local block of a previous cache
+    Connection& connection;
+    mutable std::mutex mtx;
+    std::list<uint16_t> lru;  // most recently used first
+    shared_ptr<const Block> blocks[AIRPORT_COUNT];
+    std::list<uint16_t>::iterator lru_pos[AIRPORT_COUNT];
+    std::atomic<uint64_t> hits, faults, evictions;
+
+    // without `mtx` held: reading the parquet is by far the slowest part
+    std::vector<shared_ptr<Block>> fetch(const std::vector<uint16_t>& o_idxs) const;
+    // with `mtx` held
+    void insert(uint16_t o_idx, shared_ptr<const Block> block);
+};
+
+// where route evaluation reads a pair's demand from: the game's demand as the base layer, optionally under an override
+// layer. layers are kept per key (e.g. a user or an alliance id), at most `capacity` of them with the least recently
+// used evicted. writers publish a new snapshot of the layer, so readers holding one never take a lock.
+class DemandProvider {
+   public:
+    static constexpr size_t DEFAULT_CAPACITY = 1024;
+    const size_t capacity;
+
+    DemandProvider(size_t capacity = DEFAULT_CAPACITY);
+
+    // the base layer, either the whole table (Database::pax_demands) or blocks paged in on demand. switched by
+    // Database::populate_internal() only, never while a search runs.
+    void use_table(const PaxDemand* table);
+    void use_blocks(std::unique_ptr<DemandBlockCache> blocks);
+    // null when the whole table is loaded
+    DemandBlockCache* blocks() const;
+
+    // lock free once the block of the origin is cached. a null layer reads the base layer
+    PaxDemand get(uint32_t route_idx, const DemandLayer* layer = nullptr) const;
+    PaxDemand get(uint16_t o_idx, uint16_t d_idx, const DemandLayer* layer = nullptr) const;
+    // snapshot of the layer `key`, null if there is none. marks the layer as recently used
+    shared_ptr<const DemandLayer> layer(const string& key);
+    // overrides the given pairs in the layer `key`, creating it if needed
+    void set(const string& key, const std::vector<std::pair<uint32_t, PaxDemand>>& overrides);
+    void set(const string& key, const Airport& a0, const Airport& a1, const PaxDemand& demand);
+    // drops the override of one pair, the pair reads the base layer again
+    bool unset(const string& key, uint32_t route_idx);
+    bool erase(const string& key);
+    size_t size() const;
+
+   private:
+    const PaxDemand* table;
+    std::unique_ptr<DemandBlockCache> block_cache;
+    mutable std::mutex mtx;
+    uint64_t last_version;
+    std::list<string> lru;  // most recently used first
+    std::unordered_map<string, std::pair<shared_ptr<const DemandLayer>, std::list<string>::iterator>> layers;
+
+    // with `mtx` held
+    void publish(const string& key, shared_ptr<DemandLayer> layer);
+};
+
 // multiple threads can use the same connection?
 // https://github.com/duckdb/duckdb/blob/8c32403411d628a400cc32e5fe73df87eb5aad7d/test/api/test_api.cpp#L142
 struct Database {
@@ -51,13 +151,34 @@ struct Database {
 
     Airport airports[AIRPORT_COUNT];                    // 1,031,448 B
     uint16_t airport_id_hashtable[AIRPORT_ID_MAX + 1];  // 63,728 B: airport id -> airports index
-    Airport get_airport_by_id(uint16_t id);
+    // structure-of-arrays copy of the fields hot loops filter on, indexed like `airports` (~110 kB in total).
+    // continents and countries are dictionary encoded: `continent[i]` indexes into `continent_names`.
+    struct AirportColumns {
+        uint16_t id[AIRPORT_COUNT];
+        uint16_t rwy[AIRPORT_COUNT];
+        double lat[AIRPORT_COUNT];
+        double lng[AIRPORT_COUNT];
+        uint8_t market[AIRPORT_COUNT];
+        uint32_t hub_cost[AIRPORT_COUNT];
+        uint8_t continent[AIRPORT_COUNT];
+        uint16_t country[AIRPORT_COUNT];
+        std::vector<string> continent_names;
+        std::vector<string> country_names;
+    } airport_columns;
     // note: input string are assumed to be already uppercased
-    Airport get_airport_by_iata(const string& iata);
-    Airport get_airport_by_icao(const string& icao);
-    Airport get_airport_by_name(const string& name);
-    Airport get_airport_by_fullname(const string& name);
-    Airport get_airport_by_all(const string& all);
+    // index into `airports`, AIRPORT_COUNT if there is no match
+    uint16_t find_airport_by_id(uint16_t id);
+    uint16_t find_airport_by_iata(std::string_view iata);
+    uint16_t find_airport_by_icao(std::string_view icao);
+    uint16_t find_airport_by_name(std::string_view name);
+    uint16_t find_airport_by_fullname(std::string_view name);
+    uint16_t find_airport_by_all(std::string_view all);
+    Airport get_airport_by_id(uint16_t id);
+    Airport get_airport_by_iata(std::string_view iata);
+    Airport get_airport_by_icao(std::string_view icao);
+    Airport get_airport_by_name(std::string_view name);
+    Airport get_airport_by_fullname(std::string_view name);
+    Airport get_airport_by_all(std::string_view all);
 
     template <typename ScoreFn>
     std::vector<Airport::Suggestion> suggest_airport(const string& input, ScoreFn score_fn);
@@ -68,12 +189,19 @@ struct Database {
     std::vector<Airport::Suggestion> suggest_airport_by_all(const string& all);
 
     Aircraft aircrafts[AIRCRAFT_COUNT];
+    // every aircraft with each combination of mods already applied, indexed by Aircraft::mods_variant()
+    Aircraft aircraft_variants[AIRCRAFT_COUNT][Aircraft::MODS_VARIANTS];
     static uint16_t get_aircraft_idx_by_id(uint16_t id, uint8_t priority = 0);
     // note: input string are assumed to be already lowercased
+    // index into `aircrafts`, AIRCRAFT_COUNT if there is no match
+    uint16_t find_aircraft_by_id(uint16_t id, uint8_t priority);
+    uint16_t find_aircraft_by_shortname(std::string_view shortname, uint8_t priority);
+    uint16_t find_aircraft_by_name(std::string_view name, uint8_t priority);
+    uint16_t find_aircraft_by_all(std::string_view all, uint8_t priority);
     Aircraft get_aircraft_by_id(uint16_t id, uint8_t priority);
-    Aircraft get_aircraft_by_shortname(const string& shortname, uint8_t priority);
-    Aircraft get_aircraft_by_name(const string& name, uint8_t priority);
-    Aircraft get_aircraft_by_all(const string& all, uint8_t priority);
+    Aircraft get_aircraft_by_shortname(std::string_view shortname, uint8_t priority);
+    Aircraft get_aircraft_by_name(std::string_view name, uint8_t priority);
+    Aircraft get_aircraft_by_all(std::string_view all, uint8_t priority);
 
     template <typename ScoreFn>
     std::vector<Aircraft::Suggestion> suggest_aircraft(const string& input, ScoreFn score_fn);
@@ -81,19 +209,33 @@ struct Database {
     std::vector<Aircraft::Suggestion> suggest_aircraft_by_name(const string& name);
     std::vector<Aircraft::Suggestion> suggest_aircraft_by_all(const string& all);
 
-    PaxDemand pax_demands[ROUTE_COUNT];
+    std::unique_ptr<PaxDemand[]> pax_demands;  // 45,782,226 B, not allocated when the demand is loaded lazily
+    DemandProvider demand_provider;
     double distances[AIRPORT_COUNT][AIRPORT_COUNT];  // 96,799,832 B
+    // row of the pair in routes.parquet, which holds the upper triangle of the airport x airport matrix row by row
     static inline uint32_t get_dbroute_idx(uint16_t oidx, uint16_t didx) {
         if (oidx > didx) return ((didx * (2 * AIRPORT_COUNT - didx - 1)) >> 1) + oidx - didx - 1;
         return ((oidx * (2 * AIRPORT_COUNT - oidx - 1)) >> 1) + didx - oidx - 1;
     };
+    // inverse of get_dbroute_idx(): the airport indices of the pair, the smaller one first
+    static std::pair<uint16_t, uint16_t> get_dbroute_airports(uint32_t route_idx);
+
+    // per origin: every other airport index, by ascending distance (ties by index). built on first use, 7.8 kB each
+    std::vector<uint16_t> neighbours[AIRPORT_COUNT];
+    std::once_flag neighbours_built[AIRPORT_COUNT];
+    const std::vector<uint16_t>& get_neighbours(uint16_t o_idx);
 
     static shared_ptr<Database> default_client;
     static shared_ptr<Database> Client();
     static shared_ptr<Database> Client(const string& home_dir);
 
     void populate_database();
-    void populate_internal();
+    // with `lazy_demand`, demand is paged in per origin by a DemandBlockCache of `demand_cache_bytes` instead
+    void populate_internal(
+        bool lazy_demand = false, size_t demand_cache_bytes = DemandBlockCache::DEFAULT_CAPACITY_BYTES
+    );
+    void build_airport_columns();
+    void build_aircraft_variants();
 };
 
 struct CompareSuggestion {
@@ -101,5 +243,7 @@ struct CompareSuggestion {
     bool operator()(const Aircraft::Suggestion& s1, const Aircraft::Suggestion& s2) { return s1.score > s2.score; }
 };
 
-void init(string home_dir);
+void init(
+    string home_dir, bool lazy_demand = false, size_t demand_cache_bytes = DemandBlockCache::DEFAULT_CAPACITY_BYTES
+);
 void _debug_query(string query);
\ No newline at end of file
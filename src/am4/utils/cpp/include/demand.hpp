@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <cstdint>
+#include <unordered_map>
 
 using std::string;
 using std::to_string;
@@ -31,6 +32,18 @@ struct CargoDemand {
     static const string repr(const CargoDemand& demand);
 };
 
+// demand that replaces the game's on some airport pairs, keyed by Database::get_dbroute_idx(). never modified once
+// the DemandProvider publishes it, so searches read it without locking.
+struct DemandLayer {
+    string key;
+    uint64_t version;  // unique across every layer the provider has published
+    std::unordered_map<uint32_t, PaxDemand> overrides;
+
+    DemandLayer() : version(0) {}
+    // the override of the pair if there is one, `base` otherwise
+    PaxDemand get(uint32_t route_idx, const PaxDemand& base) const;
+};
+
 #if BUILD_PYBIND == 1
 #include "binder.hpp"
 
@@ -0,0 +1,85 @@
+#pragma once
+#include <optional>
+
+#include "route.hpp"
+
+// distributes a fleet of one aircraft model over the routes of a search. every route has its own demand, so adding an
+// aircraft to a route only changes that route's config: the allocator hands out aircraft one at a time, each to the
+// route whose profit per day grows the most by it.
+class FleetAllocator {
+   public:
+    struct Plan {
+        vector<Destination> destinations;  // ac_route holds the allocated num_ac, config, income and profit
+        vector<double> marginal_profits;   // profit per day added by each aircraft, in allocation order
+        uint16_t num_ac;
+        double profit_per_day;
+        double aircraft_cost;  // purchase price of the allocated aircraft
+
+        Plan() : num_ac(0), profit_per_day(0), aircraft_cost(0) {}
+    };
+
+    const RoutesSearch search;
+    const uint16_t fleet_size;
+    const std::optional<double> budget;  // caps the fleet size by the aircraft price
+
+    FleetAllocator(const RoutesSearch& search, uint16_t fleet_size, std::optional<double> budget = std::nullopt);
+
+    uint16_t max_num_ac() const;
+    // runs the search and allocates over every destination
+    Plan allocate() const;
+    // allocates over destinations already found by `search`
+    Plan allocate(const vector<Destination>& destinations) const;
+};
+
+// plans a fleet mix over several hubs at once. every hub x aircraft search runs on its own thread, then aircraft are
+// handed out greedily across all of them. routes that fly the same airport pair (two hubs serving each other, or two
+// aircraft models on one route) draw from one demand pool, so a route's config is solved against what the others
+// leave of that pair's demand.
+class NetworkPlanner {
+   public:
+    struct FleetEntry {
+        Aircraft aircraft;
+        uint16_t count;
+
+        FleetEntry(const Aircraft& aircraft, uint16_t count) : aircraft(aircraft), count(count) {}
+    };
+
+    struct Assignment {
+        Airport hub;
+        uint16_t fleet_idx;       // index into `fleet`
+        Destination destination;  // ac_route holds the allocated num_ac, config, income and profit
+    };
+
+    struct Plan {
+        vector<Assignment> assignments;  // by descending profit per day
+        vector<double> marginal_profits;
+        vector<uint16_t> num_ac;  // per fleet entry
+        double profit_per_day;
+        bool truncated;  // some search was cut short by the token
+
+        Plan() : profit_per_day(0), truncated(false) {}
+    };
+
+    const vector<Airport> hubs;
+    const vector<FleetEntry> fleet;
+    const AircraftRoute::Options options;
+    const User user;
+    const uint16_t threads;  // 0 uses every core
+
+    NetworkPlanner(
+        const vector<Airport>& hubs,
+        const vector<FleetEntry>& fleet,
+        const AircraftRoute::Options& options = AircraftRoute::Options(),
+        const User& user = User::Default(),
+        uint16_t threads = 0
+    );
+
+    Plan plan(const CancellationToken& token = CancellationToken()) const;
+};
+
+#if BUILD_PYBIND == 1
+#include "binder.hpp"
+
+py::dict to_dict(const FleetAllocator::Plan& p);
+py::dict to_dict(const NetworkPlanner::Plan& p);
+#endif
@@ -110,8 +110,15 @@ struct Campaign {
     static Campaign parse(const string& s);
     double estimate_pax_reputation(double base_reputation = 45);
     double estimate_cargo_reputation(double base_reputation = 45);  // todo: get estimation range
+    // pax, cargo and eco campaigns together, for a user who has ever owned `planes` aircraft
+    double estimate_cost(uint16_t planes) const;
 
     static double _estimate_airline_reputation(Airline airline);
     static double _estimate_eco_reputation(Eco eco);
+    static double _estimate_airline_cost(Airline airline, uint16_t planes);
+    static double _estimate_eco_cost(Eco eco, uint16_t planes);
+    // hours, 0 if not activated
+    static uint8_t _duration(Airline airline);
+    static uint8_t _duration(Eco eco);
     bool _set(const string& s);
 };
\ No newline at end of file
@@ -2,12 +2,20 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <limits>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 
 #include "game.hpp"
 #include "ticket.hpp"
 #include "demand.hpp"
 #include "airport.hpp"
 #include "aircraft.hpp"
+#include "log.hpp"
 
 using std::string;
 using std::to_string;
@@ -18,6 +26,32 @@ constexpr double MAX_DISTANCE = 6371 * M_PI;
 
 struct AircraftRoute;
 
+// demand already taken on some airport pairs, e.g. by a user's existing routes, subtracted from the pair's demand when
+// a route is created. sparse and copy-on-write: copies share one map until one of them consumes more, so an overlay
+// is cheap to hand to every search of a user and never touches the game's demand.
+class DemandOverlay {
+   public:
+    DemandOverlay();
+
+    // `route_idx` as in Database::get_dbroute_idx(). demand is shared by both directions of a pair, and so is this
+    void consume(uint32_t route_idx, const PaxDemand& demand);
+    void consume(const Airport& a0, const Airport& a1, const PaxDemand& demand);
+    // every route of the list takes `per_route` from its origin/destination pair, wherever it stops over. returns the
+    // number of routes whose airports could be resolved.
+    size_t consume_route_list(const vector<UserLog::RouteDetail>& routes, const PaxDemand& per_route);
+
+    PaxDemand consumed(uint32_t route_idx) const;
+    // what is left of `full`, floored at 0
+    PaxDemand remaining(uint32_t route_idx, const PaxDemand& full) const;
+    bool empty() const;
+    size_t size() const;
+    // (route_idx, consumed) by ascending route_idx
+    vector<std::pair<uint32_t, PaxDemand>> entries() const;
+
+   private:
+    shared_ptr<const std::unordered_map<uint32_t, PaxDemand>> used;
+};
+
 struct Route {
     PaxDemand pax_demand;
     double direct_distance;
@@ -41,7 +75,21 @@ struct AircraftRoute {
     // TODO: decouple the options specific to the route finding to somewhere else
     struct Options {
         enum class TPDMode { AUTO = 0, STRICT_ALLOW_MULTIPLE_AC = 1, STRICT = 2 };
-        enum class SortBy { PER_TRIP = 0, PER_AC_PER_DAY = 1 };
+        enum class SortBy {
+            PER_TRIP = 0,                // profit per trip
+            PER_AC_PER_DAY = 1,          // profit per aircraft per day
+            PER_FLIGHT_HOUR = 2,         // profit per hour of flight time
+            CONTRIBUTION_PER_DAY = 3,    // contribution per aircraft per day
+            PER_SEAT = 4,                // profit per trip divided by the seats (cargo: % of payload) in the config
+            INCOME = 5,                  // income per trip
+            PER_DAY_AFTER_HUB_COST = 6,  // PER_AC_PER_DAY minus the destination's hub cost amortised over 30 days
+            FLIGHT_TIME = 7              // shortest flight time first
+        };
+        enum class CIObjective {
+            NONE = 0,                 // always fly at ci = 200
+            PER_AC_PER_DAY = 1,       // the ci that maximises profit per aircraft per day
+            CONTRIBUTION_PER_DAY = 2  // the ci that maximises contribution per aircraft per day, then profit
+        };
         using ConfigAlgorithm =
             std::variant<std::monostate, Aircraft::PaxConfig::Algorithm, Aircraft::CargoConfig::Algorithm>;
 
@@ -51,6 +99,12 @@ struct AircraftRoute {
         float max_flight_time;
         ConfigAlgorithm config_algorithm;
         SortBy sort_by;
+        double min_distance;
+        vector<SortBy> then_by;  // tie breaks applied in order after sort_by, before the airport id
+        CIObjective ci_objective;
+        DemandOverlay demand_overlay;
+        // snapshot of a DemandProvider layer the pairs' demand is read from, before demand_overlay is taken off
+        shared_ptr<const DemandLayer> demand_layer;
 
         Options(
             TPDMode tpd_mode = TPDMode::AUTO,
@@ -58,7 +112,11 @@ struct AircraftRoute {
             double max_distance = MAX_DISTANCE,
             float max_flight_time = 24.0f,
             ConfigAlgorithm config_algorithm = std::monostate(),
-            SortBy sort_by = SortBy::PER_TRIP
+            SortBy sort_by = SortBy::PER_TRIP,
+            double min_distance = 0.0,
+            const vector<SortBy>& then_by = {},
+            CIObjective ci_objective = CIObjective::NONE,
+            const DemandOverlay& demand_overlay = DemandOverlay()
         );
     };
     Route route;
@@ -104,6 +162,7 @@ struct AircraftRoute {
         ERR_FLIGHT_TIME_ABOVE_SPECIFIED,
         ERR_INSUFFICIENT_DEMAND,
         ERR_TRIPS_PER_DAY_TOO_HIGH,
+        ERR_DISTANCE_BELOW_SPECIFIED,
     };
     vector<Warning> warnings;
     bool valid;
@@ -118,11 +177,93 @@ struct AircraftRoute {
         const User& user = User::Default()
     );
 
-    template <bool is_vip>
+    // create() specialised for one aircraft type, game mode and tpd mode. hot loops should look the kernel up once
+    // and call it directly, rather than going through create() for every destination. a non-null `stopover` is used
+    // as is when the aircraft needs one: it must be what Stopover::find_by_efficiency() returns for the same pair.
+    using Kernel = AircraftRoute (*)(
+        const Airport&, const Airport&, const Aircraft&, const Options&, const User&, const Stopover*
+    );
+    static Kernel kernel(Aircraft::Type type, User::GameMode game_mode, Options::TPDMode tpd_mode);
+    // `Erased` is only set by create_generic()
+    template <Aircraft::Type T, User::GameMode GM, Options::TPDMode TM, bool Erased = false>
+    static AircraftRoute create_kernel(
+        const Airport& a0,
+        const Airport& a1,
+        const Aircraft& ac,
+        const Options& options,
+        const User& user,
+        const Stopover* stopover
+    );
+#if BUILD_PYBIND == 0
+    // the reference main.cpp benchmarks the kernels against: the kernel is looked up for every route, and the tpd
+    // sweep runs its callbacks through std::function.
+    static AircraftRoute create_generic(
+        const Airport& a0, const Airport& a1, const Aircraft& ac, const Options& options, const User& user
+    );
+#endif
+
+    template <bool is_vip, Options::TPDMode TM, bool Erased>
     inline void update_pax_details(uint16_t ac_capacity, const AircraftRoute::Options& options, const User& user);
+    template <Options::TPDMode TM, bool Erased>
     inline void update_cargo_details(uint32_t ac_capacity, const AircraftRoute::Options& options, const User& user);
 
-    static inline double estimate_load(
+    struct TPDPoint {
+        uint16_t trips_per_day_per_ac;
+        uint16_t num_ac;
+        Aircraft::Config config;
+        double income;  // per trip, load adjusted
+        double co2;     // per trip, at the route's ci
+        double profit;  // per trip
+    };
+    // the config, aircraft count, income and profit for every trips per day per aircraft a valid route can fly,
+    // computed in a single sweep. `ar` must have been created with the same aircraft, options and user.
+    static vector<TPDPoint> tpd_curve(
+        const AircraftRoute& ar,
+        const Aircraft& ac,
+        const Options& options = Options(),
+        const User& user = User::Default()
+    );
+    // the config, income and profit of `ar` flown by `num_ac` aircraft at its current trips per day per aircraft, or
+    // nullopt if the demand can't fill that many trips. `ar` must have been created with the same aircraft, options
+    // and user.
+    static std::optional<TPDPoint> with_num_ac(
+        const AircraftRoute& ar,
+        const Aircraft& ac,
+        uint16_t num_ac,
+        const Options& options = Options(),
+        const User& user = User::Default()
+    );
+
+    // what the income and costs of a valid route are made of, so it can be flown at another load without solving its
+    // config again. no class carries more than its share of the demand, however high the load.
+    struct LoadTerms {
+        struct Class {
+            double capacity;  // per trip at a load of 1: seats, or lbs for cargo
+            double price;
+            double demand;  // per trip
+        };
+        std::array<Class, 3> classes;  // y, j, f or l, h
+        double co2_empty;              // per trip, at a load of 0
+        double co2_full;               // per trip, at a load of 1
+        double fixed_cost;             // per trip: fuel, a-check and repair don't depend on the load
+        uint8_t co2_price;
+        uint32_t flights_per_day;      // over all aircraft
+
+        static LoadTerms of(const AircraftRoute& ar, const Aircraft& ac, const User& user = User::Default());
+        // per trip
+        double income(double load) const;
+        double profit(double load) const;
+    };
+
+    // re-flies a valid route at the cost index in [0, 200] that best meets `options.ci_objective`, keeping the
+    // trips per day within the tpd mode's constraints. a no-op unless a candidate strictly beats ci = 200. in the
+    // STRICT modes the tpd is kept, and `max_tpd` still refers to the flight time at ci = 200.
+    void optimise_ci(const Aircraft& ac, const Options& options, const User& user);
+    // recomputes the profit from the stored income and cost terms, as if the route was created with these prices.
+    // the config, stopover, trips per day and ci are kept.
+    void reprice(uint16_t fuel_price, uint8_t co2_price);
+
+    static double estimate_load(
         double reputation = 87,
         double autoprice_ratio = 1.06,
         bool has_stopover = false
@@ -130,14 +271,14 @@ struct AircraftRoute {
     static inline double calc_fuel(
         const Aircraft& ac, double distance, const User& user = User::Default(), uint8_t ci = 200
     );
-    static inline double calc_co2(
+    static double calc_co2(
         const Aircraft& ac,
         const Aircraft::PaxConfig& cfg,
         double distance,
         const User& user = User::Default(),
         uint8_t ci = 200
     );
-    static inline double calc_co2(
+    static double calc_co2(
         const Aircraft& ac,
         const Aircraft::CargoConfig& cfg,
         double distance,
@@ -155,24 +296,181 @@ struct Destination {
     Destination(const Airport& destination, const AircraftRoute& route);
 };
 
+// cooperative cancellation: copies share the same flag, so the caller can cancel a search running on another thread.
+class CancellationToken {
+   public:
+    using Clock = std::chrono::steady_clock;
+    std::optional<Clock::time_point> deadline;
+
+    CancellationToken(std::optional<double> timeout = std::nullopt);
+    void cancel();
+    bool cancelled() const;
+
+   private:
+    shared_ptr<std::atomic<bool>> flag;
+};
+
+// calls fn(0) .. fn(n - 1) spread over `threads` threads (0 uses every core), the calling thread included. the first
+// exception thrown by fn is rethrown once every thread has finished.
+void parallel_for(size_t n, uint16_t threads, const std::function<void(size_t)>& fn);
+
+class InvalidFilterException : public std::exception {
+   private:
+    string msg;
+
+   public:
+    InvalidFilterException(string msg) : msg(msg) {}
+    const char* what() const throw() { return msg.c_str(); }
+};
+
 class RoutesSearch {
    public:
+    // destinations are evaluated in chunks, the cancellation token is checked between them
+    static constexpr uint16_t CHUNK_SIZE = 64;
+
+    // restricts the destinations considered, checked against Database::airport_columns before any route is evaluated
+    struct Filter {
+        uint16_t min_rwy;
+        uint8_t min_market;
+        uint32_t max_hub_cost;
+        vector<string> continents;  // case insensitive, empty means any
+        vector<string> countries;   // case insensitive, empty means any
+        vector<uint16_t> exclude_ids;
+
+        Filter(
+            uint16_t min_rwy = 0,
+            uint8_t min_market = 0,
+            uint32_t max_hub_cost = std::numeric_limits<uint32_t>::max(),
+            const vector<string>& continents = {},
+            const vector<string>& countries = {},
+            const vector<uint16_t>& exclude_ids = {}
+        );
+        // `;`-separated clauses, e.g. "continent=Europe,Asia; market>=60; rwy>=10000; hub_cost<=500000; exclude=1,2"
+        static Filter parse(const string& expr);
+        bool empty() const;
+        // one byte per airport index: 1 if the airport passes the filter
+        vector<uint8_t> compile() const;
+    };
+
+    struct Result {
+        vector<Destination> destinations;
+        bool truncated;      // the token fired before all destinations were evaluated
+        uint16_t evaluated;  // number of candidates visited
+
+        Result() : truncated(false), evaluated(0) {}
+    };
+
     Airport origin;
     Aircraft aircraft;
     AircraftRoute::Options options;
     User user;
+    Filter filter;
 
     RoutesSearch(
         const Airport& origin,
         const Aircraft& aircraft,
         const AircraftRoute::Options& options = AircraftRoute::Options(),
-        const User& user = User::Default()
+        const User& user = User::Default(),
+        const Filter& filter = Filter()
     )
-        : origin(origin), aircraft(aircraft), options(options), user(user) {
+        : origin(origin), aircraft(aircraft), options(options), user(user), filter(filter) {
         if (options.max_distance > aircraft.range * 2) {
             this->options.max_distance = aircraft.range * 2;
         }
     }
 
+    using ChunkCallback = std::function<void(const vector<Destination>&)>;
+    class Stream;
+
+    // opaque, byte-exact identity of everything that affects the result, used to coalesce identical searches
+    string key() const;
     vector<Destination> get() const;
-};
\ No newline at end of file
+    // `on_chunk` receives the (unsorted) valid destinations of every chunk as soon as it is evaluated
+    Result run(const CancellationToken& token, const ChunkCallback& on_chunk = nullptr) const;
+    shared_ptr<Stream> stream(uint16_t top_k = 10) const;
+    // same as the first k of get(), but destinations are visited in descending order of a cheap profit upper bound
+    // and the scan stops as soon as no remaining destination can enter the top k.
+    vector<Destination> top_k(uint16_t k) const;
+    // destinations of this search with their profits recomputed for new prices and re-ranked, without solving any
+    // config, stopover or trips per day again
+    vector<Destination> reprice(vector<Destination> destinations, uint16_t fuel_price, uint8_t co2_price) const;
+    // destinations not dominated on every objective (higher sort_value() is better) by another destination, sorted as
+    // in get(). maintained with a block-nested-loops skyline while the candidates are scanned.
+    Result pareto(
+        const vector<AircraftRoute::Options::SortBy>& objectives, const CancellationToken& token = CancellationToken()
+    ) const;
+
+    static constexpr double HUB_COST_AMORTISATION_DAYS = 30;
+    // higher is better. `hub_cost` is the destination's, only used by PER_DAY_AFTER_HUB_COST
+    static double sort_value(const AircraftRoute& ar, AircraftRoute::Options::SortBy sort_by, uint32_t hub_cost = 0);
+
+    // airport indices within the search's distance window that pass the filter, nearest first
+    vector<uint16_t> candidates() const;
+
+   private:
+    // compares sort_by, then each of then_by, then the airport id
+    bool ranks_before(const Destination& a, const Destination& b) const;
+    double sort_value_upper_bound(uint16_t o_idx, uint16_t d_idx) const;
+    void sort_destinations(vector<Destination>& destinations) const;
+    void evaluate(const uint16_t* first, const uint16_t* last, vector<Destination>& out) const;
+};
+
+// pull-based variant of RoutesSearch::run: each call to next_chunk() evaluates the next CHUNK_SIZE candidates.
+// next_chunk() is meant to be driven by a single consumer, but top() and evaluated() may be polled from any thread.
+class RoutesSearch::Stream {
+   public:
+    const RoutesSearch search;
+    const uint16_t top_k;  // 0 keeps every destination in the snapshot
+
+    Stream(const RoutesSearch& search, uint16_t top_k = 10);
+    vector<Destination> next_chunk();
+    bool done() const;
+    uint16_t total() const;  // number of candidates in the distance window
+    uint16_t evaluated() const;
+    vector<Destination> top() const;  // sorted snapshot of the best destinations found so far
+
+   private:
+    const vector<uint16_t> idxs;
+    mutable std::mutex mtx;
+    uint16_t _evaluated;
+    vector<Destination> _top;
+};
+
+// the reverse of RoutesSearch: the origin and destination are fixed and every aircraft is evaluated on them, with
+// every combination of the speed, fuel and co2 mods if `include_mods`. the stopover only depends on the aircraft's
+// range and runway requirement, so it is looked up once per such class rather than once per aircraft.
+class AircraftSearch {
+   public:
+    struct Candidate {
+        Aircraft aircraft;  // with its mods applied
+        AircraftRoute ac_route;
+
+        Candidate(const Aircraft& aircraft, const AircraftRoute& ac_route) : aircraft(aircraft), ac_route(ac_route) {}
+    };
+
+    const Airport origin;
+    const Airport destination;
+    const AircraftRoute::Options options;
+    const User user;
+    const bool include_mods;
+    const uint16_t threads;  // 0 uses every core
+
+    AircraftSearch(
+        const Airport& origin,
+        const Airport& destination,
+        const AircraftRoute::Options& options = AircraftRoute::Options(),
+        const User& user = User::Default(),
+        bool include_mods = true,
+        uint16_t threads = 0
+    );
+
+    // the best k valid candidates by options.sort_by, then each of options.then_by, then the database order of the
+    // aircraft and its mods. 0 returns every valid candidate.
+    vector<Candidate> top_k(uint16_t k = 10) const;
+};
+#if BUILD_PYBIND == 1
+#include "binder.hpp"
+
+py::dict to_dict(const Destination& d);
+py::dict to_dict(const AircraftSearch::Candidate& c);
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "route.hpp"
+
+using std::string;
+
+class SchedulerRejectedException : public std::exception {
+   private:
+    string msg;
+
+   public:
+    SchedulerRejectedException(string msg) : msg(msg) {}
+    const char* what() const throw() { return msg.c_str(); }
+};
+
+// admission control for expensive searches: jobs are queued per priority class, each class has its own concurrency
+// limit on top of the global one, and jobs that cannot possibly meet their deadline are rejected upfront.
+class Scheduler {
+   public:
+    enum class Priority { INTERACTIVE = 0, API = 1, BATCH = 2 };
+    static constexpr size_t PRIORITY_COUNT = 3;
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        std::array<uint32_t, PRIORITY_COUNT> queued;    // current queue depth
+        std::array<uint32_t, PRIORITY_COUNT> running;   // current number of jobs executing
+        std::array<uint64_t, PRIORITY_COUNT> completed;
+        std::array<uint64_t, PRIORITY_COUNT> rejected;
+        std::array<uint64_t, PRIORITY_COUNT> coalesced;  // requests served by an identical search already in flight
+        std::array<double, PRIORITY_COUNT> queued_cost;  // sum of estimated cost units waiting in the queue
+        double seconds_per_unit;                         // calibrated from completed jobs
+    };
+
+    uint16_t max_concurrency;
+    std::array<uint16_t, PRIORITY_COUNT> class_limits;
+
+    Scheduler(uint16_t max_concurrency = 0, std::array<uint16_t, PRIORITY_COUNT> class_limits = {0, 0, 0});
+
+    // cost of a search in units of "one direct destination evaluation"
+    static double estimate_cost(const RoutesSearch& rs);
+    double estimate_seconds(double cost) const;
+
+    // runs the search once a slot is free. if the deadline passes mid-search, the partial result is returned.
+    // concurrent submissions of an identical search (same RoutesSearch::key()) share a single computation, as long as
+    // it runs at the same or a higher priority.
+    RoutesSearch::Result submit(
+        const RoutesSearch& rs, Priority priority = Priority::INTERACTIVE, std::optional<double> timeout = std::nullopt
+    );
+    Stats stats() const;
+
+    // created on first use; safe to reach from several threads at once
+    static shared_ptr<Scheduler> Default();
+
+   private:
+    mutable std::mutex mtx;
+    std::condition_variable cv;
+    std::array<std::deque<uint64_t>, PRIORITY_COUNT> queues;
+    uint64_t next_ticket = 0;
+    uint16_t running_total = 0;
+    Stats _stats;
+    std::unordered_map<string, std::shared_future<RoutesSearch::Result>> inflight;  // by (key, class), guarded by mtx
+
+    bool can_start(size_t p, uint64_t ticket) const;
+    double estimate_wait(size_t p) const;  // requires lock
+    void acquire(size_t p, double cost, std::optional<Clock::time_point> deadline);
+    void release(size_t p, double cost, double elapsed);
+    RoutesSearch::Result execute(const RoutesSearch& rs, size_t p, const CancellationToken& token);
+};
+
+inline const string to_string(Scheduler::Priority priority);
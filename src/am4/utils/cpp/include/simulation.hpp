@@ -0,0 +1,134 @@
+#pragma once
+#include <optional>
+
+#include "route.hpp"
+
+// spreads the point estimate of a route (every flight at `user.load`) into percentile bands. the load of every flight
+// of a day is drawn on its own: normal with a standard deviation of 6.8% of the mean when the ticket is priced above
+// autoprice, uniform within 5.2% of the mean otherwise. draws come from a counter based generator, so a result only
+// depends on the seed and the route, never on how the samples were spread over threads.
+class LoadSimulation {
+   public:
+    // the config is kept: a sampled day carries more or fewer passengers in the same seats, never more than the demand
+    struct Bands {
+        double p10;
+        double p50;
+        double p90;
+        double mean;
+
+        Bands() : p10(0), p50(0), p90(0), mean(0) {}
+    };
+
+    struct Result {
+        Bands load;    // averaged over the day's flights
+        Bands income;  // per day, over all trips of all aircraft
+        Bands profit;  // per day
+        uint32_t flights_per_day;
+        double mean_load;  // the centre of the distribution
+
+        Result() : flights_per_day(0), mean_load(0) {}
+    };
+
+    // samples are simulated in chunks of this size, one chunk per job
+    static constexpr uint32_t CHUNK_SIZE = 256;
+
+    const uint32_t samples;
+    const double autoprice_ratio;
+    const std::optional<double> reputation;  // centres the load at estimate_load() instead of `user.load`
+    const uint64_t seed;
+    const uint16_t threads;  // 0 uses every core
+
+    LoadSimulation(
+        uint32_t samples = 1000,
+        double autoprice_ratio = 1.06,
+        std::optional<double> reputation = std::nullopt,
+        uint64_t seed = 0,
+        uint16_t threads = 0
+    );
+
+    double mean_load(const AircraftRoute& ar, const User& user = User::Default()) const;
+    // `stream` tells apart the draws of different routes under the same seed, e.g. the destination's airport id
+    Result run(
+        const AircraftRoute& ar, const Aircraft& ac, const User& user = User::Default(), uint64_t stream = 0
+    ) const;
+    // every destination of one aircraft at once, streams keyed by the destination's airport id
+    vector<Result> run(const vector<Destination>& destinations, const Aircraft& ac, const User& user) const;
+    // the best `k` destinations of a search with their bands, in the search's order
+    vector<std::pair<Destination, Result>> top_k(const RoutesSearch& search, uint16_t k = 10) const;
+
+   private:
+    struct Job;
+    Job make_job(const AircraftRoute& ar, const Aircraft& ac, const User& user, uint64_t stream) const;
+    vector<Result> run_jobs(const vector<Job>& jobs) const;
+    void simulate(const Job& job, uint32_t first, uint32_t last, double* load_sums) const;
+    Result summarise(const Job& job, vector<double>& load_sums) const;
+};
+
+// what-if for marketing campaigns over a whole network. the reputation a campaign adds raises the expected load of
+// every route (AircraftRoute::estimate_load()), flown with the config it already has. each route is evaluated once per
+// reputation a campaign can lead to, after which any campaign is scored without touching the routes again.
+class CampaignPlanner {
+   public:
+    struct Entry {
+        Aircraft aircraft;
+        AircraftRoute ac_route;
+
+        Entry(const Aircraft& aircraft, const AircraftRoute& ac_route) : aircraft(aircraft), ac_route(ac_route) {}
+    };
+
+    struct Outcome {
+        Campaign campaign;
+        double gain;  // profit added while the campaign runs
+        double cost;
+        double net;
+        double pax_reputation;  // while every part of the campaign runs
+        double cargo_reputation;
+    };
+
+    const double base_reputation;
+    const double autoprice_ratio;
+    const uint16_t planes;  // ever owned: the user's accumulated count, at least the aircraft flying the routes
+
+    CampaignPlanner(
+        const vector<Entry>& routes,
+        const User& user = User::Default(),
+        double base_reputation = 45,
+        double autoprice_ratio = 1.06
+    );
+    // e.g. the destinations of a search, or a page of stored results
+    CampaignPlanner(
+        const vector<Destination>& destinations,
+        const Aircraft& ac,
+        const User& user = User::Default(),
+        double base_reputation = 45,
+        double autoprice_ratio = 1.06
+    );
+
+    // every airline tier with and without the eco campaign, all running for `hours`. pax or cargo tiers are only
+    // tried if the network has routes of that kind.
+    vector<Campaign> candidates(uint8_t hours = 24) const;
+    Outcome evaluate(const Campaign& campaign) const;
+    // by descending net gain
+    vector<Outcome> rank(const vector<Campaign>& campaigns) const;
+    vector<Outcome> rank(uint8_t hours = 24) const;
+    // of the whole network at the base reputation
+    double profit_per_day() const;
+
+   private:
+    static constexpr uint8_t LEVELS = 10;  // airline tier 0-4 x eco
+    // profit per day of the pax (vip included) and the cargo routes at each reputation level
+    std::array<double, LEVELS> pax_profit;
+    std::array<double, LEVELS> cargo_profit;
+    bool has_pax;
+    bool has_cargo;
+
+    double reputation(uint8_t tier, bool eco) const;
+};
+
+#if BUILD_PYBIND == 1
+#include "binder.hpp"
+
+py::dict to_dict(const LoadSimulation::Bands& b);
+py::dict to_dict(const LoadSimulation::Result& r);
+py::dict to_dict(const CampaignPlanner::Outcome& o);
+#endif
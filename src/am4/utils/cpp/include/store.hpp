@@ -0,0 +1,92 @@
+#pragma once
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <unordered_map>
+
+#include "route.hpp"
+#include "scheduler.hpp"
+
+using std::string;
+
+class CursorNotFoundException : public std::exception {
+   private:
+    string msg;
+
+   public:
+    CursorNotFoundException(string msg) : msg(msg) {}
+    const char* what() const throw() { return msg.c_str(); }
+};
+
+// bounded LRU cache of complete search results, so that paging through them does not rerun the search.
+// rows are stored as (airport index, route) pairs and only materialised into Destinations for the requested page.
+class ResultStore {
+   public:
+    using SortBy = AircraftRoute::Options::SortBy;
+
+    struct Page {
+        vector<Destination> destinations;
+        string cursor;
+        uint32_t offset;
+        uint32_t total;
+        bool has_more;
+        bool truncated;  // the underlying search did not finish before its deadline
+    };
+
+    const size_t capacity;
+
+    ResultStore(size_t capacity = 128);
+
+    // stores an already sorted result and returns its cursor
+    string put(const RoutesSearch& rs, const RoutesSearch::Result& result);
+    // runs the search through the scheduler, stores it and returns the first page
+    Page search(
+        const RoutesSearch& rs,
+        uint16_t limit = 50,
+        Scheduler::Priority priority = Scheduler::Priority::API,
+        std::optional<double> timeout = std::nullopt
+    );
+    Page page(
+        const string& cursor, uint32_t offset = 0, uint16_t limit = 50, std::optional<SortBy> sort_by = std::nullopt
+    );
+    // recomputes every stored profit for new prices (nullopt keeps the current one) and re-ranks the rows in the
+    // search's order. readers holding the previous rows keep a consistent snapshot.
+    void reprice(
+        const string& cursor,
+        std::optional<uint16_t> fuel_price = std::nullopt,
+        std::optional<uint8_t> co2_price = std::nullopt
+    );
+    bool erase(const string& cursor);
+    size_t size() const;
+
+    // created on first use; safe to reach from several threads at once
+    static shared_ptr<ResultStore> Default();
+
+   private:
+    struct Entry {
+        SortBy sort_by;  // the order of the rows as stored
+        vector<SortBy> then_by;
+        uint16_t fuel_price;  // the prices the profits were computed with
+        uint8_t co2_price;
+        bool truncated;
+        vector<uint16_t> airport_idxs;
+        vector<AircraftRoute> routes;
+
+        std::mutex mtx;
+        std::map<SortBy, vector<uint32_t>> orders;  // lazily computed permutations for the other sort keys
+    };
+
+    mutable std::mutex mtx;
+    std::list<string> lru;  // most recently used first
+    std::unordered_map<string, std::pair<shared_ptr<Entry>, std::list<string>::iterator>> entries;
+    std::mt19937_64 rng;
+
+    string new_cursor();  // requires lock
+    shared_ptr<Entry> get(const string& cursor);
+    // the permutation of the rows in RoutesSearch::ranks_before order: every key in turn, then the airport id
+    static vector<uint32_t> rank_rows(
+        const vector<uint16_t>& airport_idxs, const vector<AircraftRoute>& routes, const vector<SortBy>& keys
+    );
+};
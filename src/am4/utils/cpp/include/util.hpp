@@ -1,18 +1,52 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include <charconv>
 #include <cstdint>
-#include <stdexcept>
 
-inline bool str_to_uint16(const std::string& str, uint16_t& out) {
-    try {
-        std::size_t pos;
-        int i = std::stoi(str, &pos);
-        if (i < 0 || i > 65535) throw std::out_of_range("out of range");
-        if (pos != str.size()) throw std::invalid_argument("trailing");
-        out = static_cast<uint16_t>(i);
-        return true;
-    } catch (std::invalid_argument&) {
-    } catch (std::out_of_range&) {
+// the whole of `str` must be the number: no sign, whitespace or trailing characters
+inline bool str_to_uint16(std::string_view str, uint16_t& out) {
+    const char* last = str.data() + str.size();
+    auto [ptr, ec] = std::from_chars(str.data(), last, out);
+    return ec == std::errc() && ptr == last;
+}
+
+inline char ascii_lower(char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; }
+inline char ascii_upper(char c) { return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c; }
+
+inline std::string to_lower(std::string_view s) {
+    std::string out(s.size(), '\0');
+    for (size_t i = 0; i < s.size(); i++) out[i] = ascii_lower(s[i]);
+    return out;
+}
+
+inline std::string to_upper(std::string_view s) {
+    std::string out(s.size(), '\0');
+    for (size_t i = 0; i < s.size(); i++) out[i] = ascii_upper(s[i]);
+    return out;
+}
+
+// case insensitive `prefix`, which must be given in lowercase
+inline bool starts_with_lower(std::string_view s, std::string_view prefix) {
+    if (s.size() < prefix.size()) return false;
+    for (size_t i = 0; i < prefix.size(); i++) {
+        if (ascii_lower(s[i]) != prefix[i]) return false;
     }
-    return false;
-}
\ No newline at end of file
+    return true;
+}
+
+// `s` compared case insensitively to `folded`, which must already be lowercased (or uppercased if `upper`)
+template <bool upper>
+inline bool equals_folded(std::string_view s, std::string_view folded) {
+    if (s.size() != folded.size()) return false;
+    for (size_t i = 0; i < s.size(); i++) {
+        if ((upper ? ascii_upper(s[i]) : ascii_lower(s[i])) != folded[i]) return false;
+    }
+    return true;
+}
+
+inline std::string_view trim_spaces(std::string_view s) {
+    while (!s.empty() && s.front() == ' ') s.remove_prefix(1);
+    while (!s.empty() && s.back() == ' ') s.remove_suffix(1);
+    return s;
+}
@@ -94,6 +94,37 @@ int main() {
         // auto cfg = std::get<Aircraft::PaxConfig>(results.config);
         // __itt_task_end(domain);
         timer.stop();
+
+        // the generic path (kernel looked up per route, type-erased tpd sweep), per-route dispatch through create(),
+        // and the kernel looked up once per search, over the same candidates
+        auto rs = RoutesSearch(ap0, ac, options, user);
+        const auto idxs = rs.candidates();
+        const auto& db = Database::Client();
+        constexpr int REPEATS = 20;
+        size_t valid_generic = 0, valid_create = 0, valid_kernel = 0;
+        cout << "create_generic() x" << idxs.size() * REPEATS << ": ";
+        timer = Timer();
+        for (int r = 0; r < REPEATS; r++) {
+            for (uint16_t idx : idxs)
+                valid_generic += AircraftRoute::create_generic(ap0, db->airports[idx], ac, options, user).valid;
+        }
+        timer.stop();
+        cout << "create() x" << idxs.size() * REPEATS << ": ";
+        timer = Timer();
+        for (int r = 0; r < REPEATS; r++) {
+            for (uint16_t idx : idxs)
+                valid_create += AircraftRoute::create(ap0, db->airports[idx], ac, options, user).valid;
+        }
+        timer.stop();
+        const auto create = AircraftRoute::kernel(ac.type, user.game_mode, options.tpd_mode);
+        cout << "kernel() x" << idxs.size() * REPEATS << ": ";
+        timer = Timer();
+        for (int r = 0; r < REPEATS; r++) {
+            for (uint16_t idx : idxs) valid_kernel += create(ap0, db->airports[idx], ac, options, user, nullptr).valid;
+        }
+        timer.stop();
+        if (valid_generic != valid_kernel || valid_create != valid_kernel)
+            cerr << "the three paths disagree on which routes are valid" << endl;
         // getchar();
 
     } catch (DatabaseException& e) {
@@ -1,13 +1,70 @@
 #include <math.h>
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <cmath>
 #include <iostream>
+#include <map>
+#include <thread>
 
 #include "include/route.hpp"
 #include "include/db.hpp"
 
 using std::get;
 
+DemandOverlay::DemandOverlay() : used(std::make_shared<const std::unordered_map<uint32_t, PaxDemand>>()) {}
+
+// the map is never modified in place: consuming copies it if any other overlay still shares it
+void DemandOverlay::consume(uint32_t route_idx, const PaxDemand& demand) {
+    auto map = used.use_count() == 1 ? std::const_pointer_cast<std::unordered_map<uint32_t, PaxDemand>>(used)
+                                     : std::make_shared<std::unordered_map<uint32_t, PaxDemand>>(*used);
+    PaxDemand& d = (*map)[route_idx];
+    auto add = [](uint16_t a, uint16_t b) { return static_cast<uint16_t>(std::min(uint32_t(a) + b, uint32_t(65535))); };
+    d = PaxDemand(add(d.y, demand.y), add(d.j, demand.j), add(d.f, demand.f));
+    used = map;
+}
+
+void DemandOverlay::consume(const Airport& a0, const Airport& a1, const PaxDemand& demand) {
+    if (a0.id == a1.id) throw SameOdException();
+    const auto& db = Database::Client();
+    consume(Database::get_dbroute_idx(db->airport_id_hashtable[a0.id], db->airport_id_hashtable[a1.id]), demand);
+}
+
+size_t DemandOverlay::consume_route_list(const vector<UserLog::RouteDetail>& routes, const PaxDemand& per_route) {
+    size_t resolved = 0;
+    for (const UserLog::RouteDetail& r : routes) {
+        const auto origin = Airport::search(r.origin).ap;
+        const auto destination = Airport::search(r.destination).ap;
+        if (!origin->valid || !destination->valid || origin->id == destination->id) continue;
+        consume(*origin, *destination, per_route);
+        resolved++;
+    }
+    return resolved;
+}
+
+PaxDemand DemandOverlay::consumed(uint32_t route_idx) const {
+    auto it = used->find(route_idx);
+    return it == used->end() ? PaxDemand() : it->second;
+}
+
+PaxDemand DemandOverlay::remaining(uint32_t route_idx, const PaxDemand& full) const {
+    auto it = used->find(route_idx);
+    if (it == used->end()) return full;
+    const PaxDemand& d = it->second;
+    auto sub = [](uint16_t a, uint16_t b) { return a > b ? static_cast<uint16_t>(a - b) : uint16_t(0); };
+    return PaxDemand(sub(full.y, d.y), sub(full.j, d.j), sub(full.f, d.f));
+}
+
+bool DemandOverlay::empty() const { return used->empty(); }
+
+size_t DemandOverlay::size() const { return used->size(); }
+
+vector<std::pair<uint32_t, PaxDemand>> DemandOverlay::entries() const {
+    vector<std::pair<uint32_t, PaxDemand>> e(used->begin(), used->end());
+    std::sort(e.begin(), e.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    return e;
+}
+
 Route::Route() : direct_distance(0.0), valid(false){};
 
 // basic route meta
@@ -19,7 +76,7 @@ Route Route::create(const Airport& ap1, const Airport& ap2) {
     const uint16_t d_idx = db->airport_id_hashtable[ap2.id];
 
     Route route;
-    route.pax_demand = db->pax_demands[db->get_dbroute_idx(o_idx, d_idx)];
+    route.pax_demand = db->demand_provider.get(o_idx, d_idx);
     route.direct_distance = db->distances[o_idx][d_idx];
     route.valid = true;
     return route;
@@ -38,22 +95,22 @@ inline double Route::calc_distance(const Airport& ap1, const Airport& ap2) {
     return calc_distance(ap1.lat, ap1.lng, ap2.lat, ap2.lng);
 }
 
-template <typename Cfg>
+template <AircraftRoute::Options::TPDMode TM, typename EstMaxTpd, typename CalcCfg, typename CalcMaxIncome>
 void tpd_sweep(
     const User& user,
     const AircraftRoute::Options& options,
-    std::function<double()> est_max_tpd,
-    std::function<Cfg(double)> calc_cfg,
-    std::function<uint32_t(const Cfg&)> calc_max_income,
+    EstMaxTpd est_max_tpd,
+    CalcCfg calc_cfg,
+    CalcMaxIncome calc_max_income,
     AircraftRoute* ar
 ) {
     // first, calculate the configuration for 1 aircraft
     double tpdpa = static_cast<double>(options.trips_per_day_per_ac);
-    if (options.tpd_mode == AircraftRoute::Options::TPDMode::AUTO) {
+    if constexpr (TM == AircraftRoute::Options::TPDMode::AUTO) {
         tpdpa = std::min(floor(24. / static_cast<double>(ar->flight_time)), floor(est_max_tpd()));
     }
-    Cfg cfg = calc_cfg(tpdpa);
-    if (options.tpd_mode != AircraftRoute::Options::TPDMode::AUTO && !cfg.valid) {
+    auto cfg = calc_cfg(tpdpa);
+    if (TM != AircraftRoute::Options::TPDMode::AUTO && !cfg.valid) {
         ar->warnings.push_back(AircraftRoute::Warning::ERR_INSUFFICIENT_DEMAND);
         ar->valid = false;
         return;
@@ -70,12 +127,12 @@ void tpd_sweep(
     }
 
     double max_income = calc_max_income(cfg);
-    if (options.tpd_mode == AircraftRoute::Options::TPDMode::STRICT) {
+    if constexpr (TM == AircraftRoute::Options::TPDMode::STRICT) {
         ar->config = cfg;
         ar->max_income = max_income;
         ar->income = max_income * user.load;
         ar->num_ac = 1;
-        ar->trips_per_day_per_ac = tpdpa;
+        ar->trips_per_day_per_ac = static_cast<uint16_t>(tpdpa);
         ar->valid = true;
         uint16_t max_tpd_demand = static_cast<uint16_t>(est_max_tpd());
         max_tpd_demand -= max_tpd_demand % static_cast<uint16_t>(floor(24. / static_cast<double>(ar->flight_time)));
@@ -109,53 +166,75 @@ void tpd_sweep(
     ar->config = cfg;
     ar->max_income = max_income;
     ar->income = max_income * user.load;
-    ar->num_ac = num_ac;
-    ar->trips_per_day_per_ac = tpdpa;
+    ar->num_ac = static_cast<uint16_t>(num_ac);
+    ar->trips_per_day_per_ac = static_cast<uint16_t>(tpdpa);
     ar->valid = true;
     ar->max_tpd = std::nullopt;
 }
 
-// TODO: use one template function for both pax and cargo
-template <bool is_vip>
-inline void AircraftRoute::update_pax_details(
-    uint16_t ac_capacity, const AircraftRoute::Options& options, const User& user
+// with `Erased`, the callbacks are wrapped in std::function first (create_generic())
+template <AircraftRoute::Options::TPDMode TM, bool Erased, typename EstMaxTpd, typename CalcCfg, typename CalcMaxIncome>
+inline void tpd_sweep(
+    const User& user,
+    const AircraftRoute::Options& options,
+    EstMaxTpd est_max_tpd,
+    CalcCfg calc_cfg,
+    CalcMaxIncome calc_max_income,
+    AircraftRoute* ar
+) {
+    if constexpr (Erased) {
+        using Cfg = decltype(calc_cfg(0.));
+        tpd_sweep<TM>(
+            user, options, std::function<double()>(est_max_tpd), std::function<Cfg(double)>(calc_cfg),
+            std::function<uint32_t(const Cfg&)>(calc_max_income), ar
+        );
+    } else {
+        tpd_sweep<TM>(user, options, est_max_tpd, calc_cfg, calc_max_income, ar);
+    }
+}
+
+// calls `fn(est_max_tpd, calc_cfg, calc_max_income, ticket)` with the demand, config and income model of a pax route
+template <bool is_vip, typename Fn>
+inline void with_pax_model(
+    const Route& route, uint16_t ac_capacity, const AircraftRoute::Options& options, const User& user, Fn fn
 ) {
     const Aircraft::PaxConfig::Algorithm config_algorithm =
         std::holds_alternative<std::monostate>(options.config_algorithm)
             ? Aircraft::PaxConfig::Algorithm::AUTO
             : get<Aircraft::PaxConfig::Algorithm>(options.config_algorithm);
-    const PaxDemand load_adj_pd = this->route.pax_demand / user.load;
+    const PaxDemand load_adj_pd = route.pax_demand / user.load;
     auto est_max_tpd = [&]() -> double {
         return static_cast<double>(load_adj_pd.y + load_adj_pd.j * 2 + load_adj_pd.f * 3) /
                static_cast<double>(ac_capacity);
     };
     auto calc_cfg = [&](double tpd) {
         return Aircraft::PaxConfig::calc_pax_conf(
-            load_adj_pd / tpd, ac_capacity, this->route.direct_distance, user.game_mode, config_algorithm
+            load_adj_pd / tpd, ac_capacity, route.direct_distance, user.game_mode, config_algorithm
         );
     };
 
     const auto tkt = [&]() {
         if constexpr (is_vip)
-            return VIPTicket::from_optimal(this->route.direct_distance, user.game_mode);
+            return VIPTicket::from_optimal(route.direct_distance, user.game_mode);
         else
-            return PaxTicket::from_optimal(this->route.direct_distance, user.game_mode);
+            return PaxTicket::from_optimal(route.direct_distance, user.game_mode);
     }();
     auto calc_max_income = [&](const Aircraft::PaxConfig& cfg) -> uint32_t {
         return (cfg.y * tkt.y + cfg.j * tkt.j + cfg.f * tkt.f);
     };
-    tpd_sweep<Aircraft::PaxConfig>(user, options, est_max_tpd, calc_cfg, calc_max_income, this);
-    this->ticket = tkt;
+    fn(est_max_tpd, calc_cfg, calc_max_income, tkt);
 }
 
-inline void AircraftRoute::update_cargo_details(
-    uint32_t ac_capacity, const AircraftRoute::Options& options, const User& user
+// same as with_pax_model, for cargo routes
+template <typename Fn>
+inline void with_cargo_model(
+    const Route& route, uint32_t ac_capacity, const AircraftRoute::Options& options, const User& user, Fn fn
 ) {
     const Aircraft::CargoConfig::Algorithm config_algorithm =
         std::holds_alternative<std::monostate>(options.config_algorithm)
             ? Aircraft::CargoConfig::Algorithm::AUTO
             : get<Aircraft::CargoConfig::Algorithm>(options.config_algorithm);
-    const CargoDemand load_adj_cd = CargoDemand(this->route.pax_demand);
+    const CargoDemand load_adj_cd = CargoDemand(route.pax_demand);
 
     auto est_max_tpd = [&]() -> double {
         double k_h = 1. + static_cast<double>(user.h_training) / 100;
@@ -170,13 +249,142 @@ inline void AircraftRoute::update_cargo_details(
             load_adj_cd / user.load / trips_per_day, ac_capacity, user.l_training, user.h_training, config_algorithm
         );
     };
-    const CargoTicket tkt = CargoTicket::from_optimal(this->route.direct_distance, user.game_mode);
-    auto calc_income = [&](const Aircraft::CargoConfig& cfg) -> double {
-        return ((1 + user.l_training / 100.0) * cfg.l * 0.7 * tkt.l + (1 + user.h_training / 100.0) * cfg.h * tkt.h) *
-               ac_capacity / 100.0;
+    const CargoTicket tkt = CargoTicket::from_optimal(route.direct_distance, user.game_mode);
+    auto calc_income = [&](const Aircraft::CargoConfig& cfg) -> uint32_t {
+        return static_cast<uint32_t>(
+            ((1 + user.l_training / 100.0) * cfg.l * 0.7 * tkt.l + (1 + user.h_training / 100.0) * cfg.h * tkt.h) *
+            ac_capacity / 100.0
+        );
+    };
+    fn(est_max_tpd, calc_cfg, calc_income, tkt);
+}
+
+template <bool is_vip, AircraftRoute::Options::TPDMode TM, bool Erased>
+inline void AircraftRoute::update_pax_details(
+    uint16_t ac_capacity, const AircraftRoute::Options& options, const User& user
+) {
+    auto sweep = [&](auto est_max_tpd, auto calc_cfg, auto calc_max_income, const auto& tkt) {
+        tpd_sweep<TM, Erased>(user, options, est_max_tpd, calc_cfg, calc_max_income, this);
+        this->ticket = tkt;
+    };
+    with_pax_model<is_vip>(this->route, ac_capacity, options, user, sweep);
+}
+
+template <AircraftRoute::Options::TPDMode TM, bool Erased>
+inline void AircraftRoute::update_cargo_details(
+    uint32_t ac_capacity, const AircraftRoute::Options& options, const User& user
+) {
+    auto sweep = [&](auto est_max_tpd, auto calc_cfg, auto calc_max_income, const auto& tkt) {
+        tpd_sweep<TM, Erased>(user, options, est_max_tpd, calc_cfg, calc_max_income, this);
+        this->ticket = tkt;
+    };
+    with_cargo_model(this->route, ac_capacity, options, user, sweep);
+}
+
+/*
+Every trips per day per aircraft the route can fly, with the aircraft count picked as in the AUTO branch of
+tpd_sweep(). The config only depends on the total trips per day (per aircraft * aircraft), so each total is solved
+at most once and shared by every (tpd, num_ac) pair with that product.
+*/
+template <typename CalcCfg, typename CalcMaxIncome, typename CalcCo2>
+vector<AircraftRoute::TPDPoint> tpd_curve_impl(
+    const AircraftRoute& ar, const User& user, CalcCfg calc_cfg, CalcMaxIncome calc_max_income, CalcCo2 calc_co2
+) {
+    using Cfg = decltype(calc_cfg(1.));
+    vector<std::optional<std::pair<Cfg, double>>> by_total;
+    auto solve = [&](uint32_t total) {
+        if (by_total.size() <= total) by_total.resize(total + 1);
+        if (!by_total[total].has_value()) {
+            const Cfg cfg = calc_cfg(static_cast<double>(total));
+            by_total[total].emplace(cfg, cfg.valid ? static_cast<double>(calc_max_income(cfg)) : 0.);
+        }
+        return by_total[total].value();
     };
-    tpd_sweep<Aircraft::CargoConfig>(user, options, est_max_tpd, calc_cfg, calc_income, this);
-    this->ticket = tkt;
+
+    vector<AircraftRoute::TPDPoint> curve;
+    const double fixed_cost = ar.fuel * user.fuel_price / 1000.0 + ar.acheck_cost + ar.repair_cost;
+    const uint16_t max_tpdpa = static_cast<uint16_t>(floor(24. / static_cast<double>(ar.flight_time)));
+    for (uint16_t tpdpa = 1; tpdpa <= max_tpdpa; tpdpa++) {
+        auto [cfg, max_income] = solve(tpdpa);
+        if (!cfg.valid) break;  // less demand per trip from here on
+
+        const double max_income_bnd = max_income * (1 - user.income_loss_tol);
+        uint16_t num_ac = 1;
+        for (uint16_t i_num_ac = 2; i_num_ac < 200; i_num_ac++) {
+            const auto [i_cfg, i_max_income] = solve(static_cast<uint32_t>(tpdpa) * i_num_ac);
+            if (!i_cfg.valid || i_max_income < max_income_bnd) break;
+            cfg = i_cfg;
+            max_income = i_max_income;
+            num_ac = i_num_ac;
+        }
+
+        AircraftRoute::TPDPoint p;
+        p.trips_per_day_per_ac = tpdpa;
+        p.num_ac = num_ac;
+        p.config = cfg;
+        p.income = max_income * user.load;
+        p.co2 = calc_co2(cfg);
+        p.profit = p.income - fixed_cost - p.co2 * user.co2_price / 1000.0;
+        curve.push_back(p);
+    }
+    return curve;
+}
+
+// with_pax_model or with_cargo_model, picked at runtime from the aircraft type
+template <typename Fn>
+inline void with_model(
+    const Route& route, const Aircraft& ac, const AircraftRoute::Options& options, const User& user, Fn fn
+) {
+    switch (ac.type) {
+        case Aircraft::Type::CARGO:
+            with_cargo_model(route, static_cast<uint32_t>(ac.capacity), options, user, fn);
+            break;
+        case Aircraft::Type::VIP:
+            with_pax_model<true>(route, static_cast<uint16_t>(ac.capacity), options, user, fn);
+            break;
+        default:
+            with_pax_model<false>(route, static_cast<uint16_t>(ac.capacity), options, user, fn);
+    }
+}
+
+vector<AircraftRoute::TPDPoint> AircraftRoute::tpd_curve(
+    const AircraftRoute& ar, const Aircraft& ac, const AircraftRoute::Options& options, const User& user
+) {
+    vector<TPDPoint> curve;
+    if (!ar.valid) return curve;
+    const double full_distance = ar.stopover.exists ? ar.stopover.full_distance : ar.route.direct_distance;
+    with_model(ar.route, ac, options, user, [&](auto, auto calc_cfg, auto calc_max_income, const auto&) {
+        curve = tpd_curve_impl(ar, user, calc_cfg, calc_max_income, [&](const auto& cfg) {
+            return AircraftRoute::calc_co2(ac, cfg, full_distance, user, ar.ci);
+        });
+    });
+    return curve;
+}
+
+std::optional<AircraftRoute::TPDPoint> AircraftRoute::with_num_ac(
+    const AircraftRoute& ar,
+    const Aircraft& ac,
+    uint16_t num_ac,
+    const AircraftRoute::Options& options,
+    const User& user
+) {
+    if (!ar.valid || num_ac == 0) return std::nullopt;
+    const double full_distance = ar.stopover.exists ? ar.stopover.full_distance : ar.route.direct_distance;
+    const double fixed_cost = ar.fuel * user.fuel_price / 1000.0 + ar.acheck_cost + ar.repair_cost;
+    std::optional<TPDPoint> point;
+    with_model(ar.route, ac, options, user, [&](auto, auto calc_cfg, auto calc_max_income, const auto&) {
+        const auto cfg = calc_cfg(static_cast<double>(ar.trips_per_day_per_ac) * num_ac);
+        if (!cfg.valid) return;
+        TPDPoint p;
+        p.trips_per_day_per_ac = ar.trips_per_day_per_ac;
+        p.num_ac = num_ac;
+        p.config = cfg;
+        p.income = static_cast<double>(calc_max_income(cfg)) * user.load;
+        p.co2 = AircraftRoute::calc_co2(ac, cfg, full_distance, user, ar.ci);
+        p.profit = p.income - fixed_cost - p.co2 * user.co2_price / 1000.0;
+        point = p;
+    });
+    return point;
 }
 
 AircraftRoute::AircraftRoute() : valid(false){};
@@ -186,32 +394,65 @@ AircraftRoute::Options::Options(
     double max_distance,
     float max_flight_time,
     ConfigAlgorithm config_algorithm,
-    SortBy sort_by
+    SortBy sort_by,
+    double min_distance,
+    const vector<SortBy>& then_by,
+    CIObjective ci_objective,
+    const DemandOverlay& demand_overlay
 )
     : tpd_mode(tpd_mode),
       trips_per_day_per_ac(trips_per_day_per_ac),
       max_distance(max_distance),
       max_flight_time(max_flight_time),
       config_algorithm(config_algorithm),
-      sort_by(sort_by) {
+      sort_by(sort_by),
+      min_distance(min_distance),
+      then_by(then_by),
+      ci_objective(ci_objective),
+      demand_overlay(demand_overlay) {
     if (tpd_mode == AircraftRoute::Options::TPDMode::AUTO && trips_per_day_per_ac != 1)
         std::cerr << "WARN: trips_per_day_per_ac is ignored when tpd_mode is AUTO" << std::endl;
 };
 AircraftRoute AircraftRoute::create(
     const Airport& a0, const Airport& a1, const Aircraft& ac, const AircraftRoute::Options& options, const User& user
 ) {
+    return AircraftRoute::kernel(ac.type, user.game_mode, options.tpd_mode)(a0, a1, ac, options, user, nullptr);
+}
+
+// the aircraft type, game mode and tpd mode are fixed for a whole search, so each combination gets its own copy of
+// create() with those branches resolved at compile time.
+template <Aircraft::Type T, User::GameMode GM, AircraftRoute::Options::TPDMode TM, bool Erased>
+AircraftRoute AircraftRoute::create_kernel(
+    const Airport& a0,
+    const Airport& a1,
+    const Aircraft& ac,
+    const AircraftRoute::Options& options,
+    const User& user,
+    const Stopover* stopover
+) {
+    constexpr bool easy = GM == User::GameMode::EASY;
     AircraftRoute acr;
     acr.route = Route::create(a0, a1);
+    if (options.demand_layer || !options.demand_overlay.empty()) {
+        const auto& db = Database::Client();
+        const uint32_t route_idx =
+            Database::get_dbroute_idx(db->airport_id_hashtable[a0.id], db->airport_id_hashtable[a1.id]);
+        if (options.demand_layer) acr.route.pax_demand = options.demand_layer->get(route_idx, acr.route.pax_demand);
+        acr.route.pax_demand = options.demand_overlay.remaining(route_idx, acr.route.pax_demand);
+    }
     acr._ac_type = ac.type;
     acr.max_tpd = std::nullopt;
 
-    if (user.game_mode == User::GameMode::REALISM && a1.rwy < ac.rwy) {
+    if (!easy && a1.rwy < ac.rwy) {
         acr.warnings.push_back(AircraftRoute::Warning::ERR_RWY_TOO_SHORT);
         return acr;
     }
     if (acr.route.direct_distance > options.max_distance) {
         acr.warnings.push_back(AircraftRoute::Warning::ERR_DISTANCE_ABOVE_SPECIFIED);
         return acr;
+    } else if (acr.route.direct_distance < options.min_distance) {
+        acr.warnings.push_back(AircraftRoute::Warning::ERR_DISTANCE_BELOW_SPECIFIED);
+        return acr;
     } else if (acr.route.direct_distance > 2 * ac.range) {
         acr.warnings.push_back(AircraftRoute::Warning::ERR_DISTANCE_TOO_LONG);
         return acr;
@@ -222,60 +463,198 @@ AircraftRoute AircraftRoute::create(
         acr.warnings.push_back(AircraftRoute::Warning::REDUCED_CONTRIBUTION);
     }
     acr.needs_stopover = acr.route.direct_distance > ac.range;
-    acr.stopover = acr.needs_stopover ? Stopover::find_by_efficiency(a0, a1, ac, user.game_mode) : Stopover();
+    if (acr.needs_stopover) acr.stopover = stopover ? *stopover : Stopover::find_by_efficiency(a0, a1, ac, GM);
     if (acr.needs_stopover && !acr.stopover.exists) {
         acr.warnings.push_back(AircraftRoute::Warning::ERR_NO_STOPOVER);
         return acr;
     }
     const double full_distance = acr.stopover.exists ? acr.stopover.full_distance : acr.route.direct_distance;
-    acr.flight_time =
-        static_cast<float>(full_distance) / (ac.speed * (user.game_mode == User::GameMode::EASY ? 1.5f : 1.0f));
+    acr.flight_time = static_cast<float>(full_distance) / (ac.speed * (easy ? 1.5f : 1.0f));
     if (acr.flight_time > options.max_flight_time) {
         acr.warnings.push_back(AircraftRoute::Warning::ERR_FLIGHT_TIME_ABOVE_SPECIFIED);
         return acr;
     }
-    if (options.tpd_mode != Options::TPDMode::AUTO &&
-        acr.flight_time > 24.0f / static_cast<float>(options.trips_per_day_per_ac)) {
+    if (TM != Options::TPDMode::AUTO && acr.flight_time > 24.0f / static_cast<float>(options.trips_per_day_per_ac)) {
         acr.warnings.push_back(AircraftRoute::Warning::ERR_TRIPS_PER_DAY_TOO_HIGH);
         return acr;
     }
-    switch (ac.type) {
-        case Aircraft::Type::PAX: {
-            acr.update_pax_details<false>(static_cast<uint16_t>(ac.capacity), options, user);
-            if (!acr.valid) return acr;
-            acr.co2 = AircraftRoute::calc_co2(ac, get<Aircraft::PaxConfig>(acr.config), full_distance, user);
-            break;
-        }
-        case Aircraft::Type::CARGO: {
-            acr.update_cargo_details(static_cast<uint32_t>(ac.capacity), options, user);
-            if (!acr.valid) return acr;
-            acr.co2 = AircraftRoute::calc_co2(ac, get<Aircraft::CargoConfig>(acr.config), full_distance, user);
-            break;
-        }
-        case Aircraft::Type::VIP: {
-            acr.update_pax_details<true>(static_cast<uint16_t>(ac.capacity), options, user);
-            if (!acr.valid) return acr;
-            acr.co2 = AircraftRoute::calc_co2(ac, get<Aircraft::PaxConfig>(acr.config), full_distance, user);
-            break;
-        }
+    if constexpr (T == Aircraft::Type::CARGO) {
+        acr.update_cargo_details<TM, Erased>(static_cast<uint32_t>(ac.capacity), options, user);
+        if (!acr.valid) return acr;
+        acr.co2 = AircraftRoute::calc_co2(ac, get<Aircraft::CargoConfig>(acr.config), full_distance, user);
+    } else {
+        acr.update_pax_details<T == Aircraft::Type::VIP, TM, Erased>(
+            static_cast<uint16_t>(ac.capacity), options, user
+        );
+        if (!acr.valid) return acr;
+        acr.co2 = AircraftRoute::calc_co2(ac, get<Aircraft::PaxConfig>(acr.config), full_distance, user);
     }
     acr.fuel = AircraftRoute::calc_fuel(ac, full_distance, user);
-    acr.acheck_cost = static_cast<float>(ac.check_cost * (user.game_mode == User::GameMode::EASY ? 0.5 : 1.0)) *
-                      ceil(acr.flight_time * (user.game_mode == User::GameMode::EASY ? 1.5 : 1.0)) /
-                      static_cast<float>(ac.maint);
+    acr.acheck_cost = static_cast<float>(ac.check_cost * (easy ? 0.5 : 1.0)) *
+                      ceil(acr.flight_time * (easy ? 1.5 : 1.0)) / static_cast<float>(ac.maint);
     acr.repair_cost =
         ac.cost / 1000.0 * 0.0075 *
         (1 - 2 * user.repair_training / 100.0);  // each flight adds random [0, 1.5]% wear, each tp decreases wear by 2%
-    acr.profit =
-        (acr.income - acr.fuel * user.fuel_price / 1000.0 - acr.co2 * user.co2_price / 1000.0 - acr.acheck_cost -
-         acr.repair_cost);
+    acr.reprice(user.fuel_price, user.co2_price);
     acr.ci = 200;
     acr.contribution = AircraftRoute::calc_contribution(full_distance, user, 200);
 
     acr.valid = true;
+    if (options.ci_objective != Options::CIObjective::NONE) acr.optimise_ci(ac, options, user);
     return acr;
 }
 
+/*
+The speed scales with (0.0035ci + 0.3), the fuel with (ci/500 + 0.6) and the co2 with (ci/2000 + 0.9): all three are 1
+at ci = 200, so every other ci is a rescale of what create() computed. A slower flight can only lower the trips per
+day: in AUTO mode the config and aircraft count for the lower tpd come from tpd_curve(), which is only solved if some
+ci needs it. The STRICT modes keep their tpd and reject any ci that no longer fits it into a day.
+*/
+void AircraftRoute::optimise_ci(const Aircraft& ac, const AircraftRoute::Options& options, const User& user) {
+    constexpr size_t N = 200;  // candidates 0..199, ci = 200 is the route as it stands
+    const bool easy = user.game_mode == User::GameMode::EASY;
+    const bool auto_tpd = options.tpd_mode == Options::TPDMode::AUTO;
+    const double full_distance = stopover.exists ? stopover.full_distance : route.direct_distance;
+    const uint16_t tpd = trips_per_day_per_ac;
+
+    // one column per quantity, so that each loop is a straight run over contiguous arrays
+    std::array<float, N> flight_times;
+    std::array<double, N> fuels, co2_factors, acheck_costs;
+    std::array<float, N> contributions;
+    std::array<uint16_t, N> tpds;
+    const float base_speed = ac.speed * (easy ? 1.5f : 1.0f);
+    const float check_cost = static_cast<float>(ac.check_cost * (easy ? 0.5 : 1.0));
+    for (size_t c = 0; c < N; c++) {
+        const uint8_t ci = static_cast<uint8_t>(c);
+        flight_times[c] = static_cast<float>(full_distance) / (base_speed * (0.0035f * static_cast<float>(c) + 0.3f));
+        fuels[c] = AircraftRoute::calc_fuel(ac, full_distance, user, ci);
+        co2_factors[c] = ci / 2000.0 + 0.9;
+        // same order of operations as create(), so ci = 200 and its neighbours round alike
+        acheck_costs[c] = check_cost * ceil(flight_times[c] * (easy ? 1.5 : 1.0)) / static_cast<float>(ac.maint);
+        contributions[c] = AircraftRoute::calc_contribution(full_distance, user, ci);
+    }
+    const float max_tpd_time = 24.0f / static_cast<float>(tpd);
+    for (size_t c = 0; c < N; c++) {
+        const float ft = flight_times[c];
+        uint16_t t = auto_tpd ? static_cast<uint16_t>(std::min(std::floor(24.0f / ft), static_cast<float>(tpd)))
+                              : (ft > max_tpd_time ? 0 : tpd);
+        tpds[c] = ft > options.max_flight_time ? 0 : t;
+    }
+
+    // income and co2 (at ci = 200) per trip, indexed by tpd. only AUTO mode ever drops below the current tpd.
+    vector<double> incomes(tpd + 1, 0.), co2s(tpd + 1, 0.);
+    incomes[tpd] = income;
+    co2s[tpd] = co2;
+    const uint16_t min_tpd = *std::min_element(tpds.begin(), tpds.end());
+    vector<TPDPoint> curve;
+    if (auto_tpd && min_tpd < tpd) {
+        curve = AircraftRoute::tpd_curve(*this, ac, options, user);
+        for (const TPDPoint& p : curve) {
+            if (p.trips_per_day_per_ac >= tpd) break;
+            incomes[p.trips_per_day_per_ac] = p.income;
+            co2s[p.trips_per_day_per_ac] = p.co2;
+        }
+        for (size_t c = 0; c < N; c++) {
+            if (tpds[c] < tpd && tpds[c] > curve.size()) tpds[c] = 0;  // the curve ran out of demand first
+        }
+    }
+
+    const bool by_contribution = options.ci_objective == Options::CIObjective::CONTRIBUTION_PER_DAY;
+    const double fuel_price = user.fuel_price / 1000.0;
+    const double co2_price = user.co2_price / 1000.0;
+    size_t best = N;
+    double best_profit = profit;
+    double best_per_day = profit * tpd;
+    double best_contribution = static_cast<double>(contribution) * tpd;
+    for (size_t c = 0; c < N; c++) {
+        const uint16_t t = tpds[c];
+        if (t == 0) continue;
+        const double p = incomes[t] - fuels[c] * fuel_price - co2s[t] * co2_factors[c] * co2_price -
+                         acheck_costs[c] - repair_cost;
+        const double per_day = p * t;
+        const double contribution_per_day = static_cast<double>(contributions[c]) * t;
+        const bool better =
+            by_contribution ? contribution_per_day > best_contribution ||
+                                  (contribution_per_day == best_contribution && per_day > best_per_day)
+                            : per_day > best_per_day;
+        if (!better) continue;
+        best = c;
+        best_profit = p;
+        best_per_day = per_day;
+        best_contribution = contribution_per_day;
+    }
+    if (best == N) return;
+
+    const uint16_t t = tpds[best];
+    if (t != tpd) {
+        const TPDPoint& p = curve[t - 1];
+        config = p.config;
+        num_ac = p.num_ac;
+        income = p.income;
+        max_income = p.income / user.load;
+        trips_per_day_per_ac = t;
+        max_tpd = std::nullopt;  // only AUTO mode changes the tpd, and it never sets max_tpd
+    }
+    ci = static_cast<uint8_t>(best);
+    flight_time = flight_times[best];
+    fuel = fuels[best];
+    co2 = co2s[t] * co2_factors[best];
+    acheck_cost = acheck_costs[best];
+    profit = best_profit;
+    contribution = contributions[best];
+}
+
+void AircraftRoute::reprice(uint16_t fuel_price, uint8_t co2_price) {
+    profit = income - fuel * fuel_price / 1000.0 - co2 * co2_price / 1000.0 - acheck_cost - repair_cost;
+}
+
+template <Aircraft::Type T, User::GameMode GM, bool Erased>
+inline AircraftRoute::Kernel select_kernel(AircraftRoute::Options::TPDMode tpd_mode) {
+    using TPDMode = AircraftRoute::Options::TPDMode;
+    switch (tpd_mode) {
+        case TPDMode::STRICT_ALLOW_MULTIPLE_AC:
+            return &AircraftRoute::create_kernel<T, GM, TPDMode::STRICT_ALLOW_MULTIPLE_AC, Erased>;
+        case TPDMode::STRICT:
+            return &AircraftRoute::create_kernel<T, GM, TPDMode::STRICT, Erased>;
+        default:
+            return &AircraftRoute::create_kernel<T, GM, TPDMode::AUTO, Erased>;
+    }
+}
+
+template <Aircraft::Type T, bool Erased>
+inline AircraftRoute::Kernel select_kernel(User::GameMode game_mode, AircraftRoute::Options::TPDMode tpd_mode) {
+    if (game_mode == User::GameMode::EASY) return select_kernel<T, User::GameMode::EASY, Erased>(tpd_mode);
+    return select_kernel<T, User::GameMode::REALISM, Erased>(tpd_mode);
+}
+
+template <bool Erased>
+inline AircraftRoute::Kernel select_kernel(
+    Aircraft::Type type, User::GameMode game_mode, AircraftRoute::Options::TPDMode tpd_mode
+) {
+    switch (type) {
+        case Aircraft::Type::CARGO:
+            return select_kernel<Aircraft::Type::CARGO, Erased>(game_mode, tpd_mode);
+        case Aircraft::Type::VIP:
+            return select_kernel<Aircraft::Type::VIP, Erased>(game_mode, tpd_mode);
+        default:
+            return select_kernel<Aircraft::Type::PAX, Erased>(game_mode, tpd_mode);
+    }
+}
+
+AircraftRoute::Kernel AircraftRoute::kernel(
+    Aircraft::Type type, User::GameMode game_mode, AircraftRoute::Options::TPDMode tpd_mode
+) {
+    return select_kernel<false>(type, game_mode, tpd_mode);
+}
+
+#if BUILD_PYBIND == 0
+AircraftRoute AircraftRoute::create_generic(
+    const Airport& a0, const Airport& a1, const Aircraft& ac, const AircraftRoute::Options& options, const User& user
+) {
+    return select_kernel<true>(ac.type, user.game_mode, options.tpd_mode)(a0, a1, ac, options, user, nullptr);
+}
+#endif
+
 AircraftRoute::Stopover::Stopover() : exists(false) {}
 AircraftRoute::Stopover::Stopover(const Airport& airport, double full_distance)
     : airport(airport), full_distance(full_distance), exists(true) {}
@@ -283,45 +662,33 @@ AircraftRoute::Stopover AircraftRoute::Stopover::find_by_efficiency(
     const Airport& origin, const Airport& destination, const Aircraft& aircraft, User::GameMode game_mode
 ) {
     const auto& db = Database::Client();
-    const auto& airports = db->airports;
     const auto& distances = db->distances;
-    Airport candidate = Airport();
-    double candidate_distance = 99999;
+    const uint16_t* rwy = db->airport_columns.rwy;
 
     const double ac_range = static_cast<double>(aircraft.range);
     const uint16_t o_idx = db->airport_id_hashtable[origin.id];
     const uint16_t d_idx = db->airport_id_hashtable[destination.id];
+    const uint16_t rwy_requirement = game_mode == User::GameMode::EASY ? 0 : aircraft.rwy;
+    const double* dist_o = distances[o_idx];
+    const double* dist_d = distances[d_idx];
+    // only touches the runway column and two distance rows: the airport itself is copied once, at the end.
     // d_o & d_d will catch cases where idx == o_idx || idx == d_idx
-    if (game_mode == User::GameMode::EASY) {
-        for (uint16_t idx = 0; idx < AIRPORT_COUNT; idx++) {
-            const Airport& ap = airports[idx];
-            const double d_o = distances[o_idx][idx];
-            if (d_o > ac_range || d_o < 100.0) continue;
-            const double d_d = distances[d_idx][idx];
-            if (d_d > ac_range || d_d < 100.0) continue;
-            if (d_o + d_d < candidate_distance) {
-                candidate = ap;
-                candidate_distance = d_o + d_d;
-            }
-        }
-    } else {
-        const uint16_t rwy_requirement = aircraft.rwy;
-        for (uint16_t idx = 0; idx < AIRPORT_COUNT; idx++) {
-            const Airport& ap = airports[idx];
-            if (ap.rwy < rwy_requirement) continue;
-            const double d_o = distances[o_idx][idx];
-            if (d_o > ac_range || d_o < 100.0) continue;
-            const double d_d = distances[d_idx][idx];
-            if (d_d > ac_range || d_d < 100.0) continue;
-            if (d_o + d_d < candidate_distance) {
-                candidate = ap;
-                candidate_distance = d_o + d_d;
-            }
+    uint16_t candidate_idx = AIRPORT_COUNT;
+    double candidate_distance = 99999;
+    for (uint16_t idx = 0; idx < AIRPORT_COUNT; idx++) {
+        if (rwy[idx] < rwy_requirement) continue;
+        const double d_o = dist_o[idx];
+        if (d_o > ac_range || d_o < 100.0) continue;
+        const double d_d = dist_d[idx];
+        if (d_d > ac_range || d_d < 100.0) continue;
+        if (d_o + d_d < candidate_distance) {
+            candidate_idx = idx;
+            candidate_distance = d_o + d_d;
         }
     }
 
-    if (!candidate.valid) return Stopover();
-    return Stopover(candidate, candidate_distance);
+    if (candidate_idx == AIRPORT_COUNT) return Stopover();
+    return Stopover(db->airports[candidate_idx], candidate_distance);
 }
 
 const string AircraftRoute::Stopover::repr(const Stopover& stopover) {
@@ -330,7 +697,62 @@ const string AircraftRoute::Stopover::repr(const Stopover& stopover) {
            " full_distance=" + to_string(stopover.full_distance) + ">";
 }
 
-inline double AircraftRoute::estimate_load(double reputation, double autoprice_ratio, bool has_stopover) {
+AircraftRoute::LoadTerms AircraftRoute::LoadTerms::of(const AircraftRoute& ar, const Aircraft& ac, const User& user) {
+    if (!ar.valid) throw std::invalid_argument("the route is not valid");
+    LoadTerms t;
+    t.flights_per_day = std::max(1u, static_cast<uint32_t>(ar.trips_per_day_per_ac) * ar.num_ac);
+    const double n = static_cast<double>(t.flights_per_day);
+    const double full_distance = ar.stopover.exists ? ar.stopover.full_distance : ar.route.direct_distance;
+    User empty = user, full = user;
+    empty.load = 0;
+    full.load = 1;
+    const PaxDemand& pd = ar.route.pax_demand;
+    if (ac.type == Aircraft::Type::CARGO) {
+        const auto& cfg = get<Aircraft::CargoConfig>(ar.config);
+        const auto& tkt = get<CargoTicket>(ar.ticket);
+        const CargoDemand cd(pd);
+        const double capacity = static_cast<double>(ac.capacity);
+        t.classes = {{
+            {capacity * cfg.l / 100.0 * 0.7 * (1 + user.l_training / 100.0), tkt.l, cd.l / n},
+            {capacity * cfg.h / 100.0 * (1 + user.h_training / 100.0), tkt.h, cd.h / n},
+            {0, 0, 0},
+        }};
+        t.co2_empty = AircraftRoute::calc_co2(ac, cfg, full_distance, empty, ar.ci);
+        t.co2_full = AircraftRoute::calc_co2(ac, cfg, full_distance, full, ar.ci);
+    } else {
+        const auto& cfg = get<Aircraft::PaxConfig>(ar.config);
+        auto set_classes = [&](const auto& tkt) {
+            t.classes = {{
+                {static_cast<double>(cfg.y), static_cast<double>(tkt.y), pd.y / n},
+                {static_cast<double>(cfg.j), static_cast<double>(tkt.j), pd.j / n},
+                {static_cast<double>(cfg.f), static_cast<double>(tkt.f), pd.f / n},
+            }};
+        };
+        if (ac.type == Aircraft::Type::VIP) {
+            set_classes(get<VIPTicket>(ar.ticket));
+        } else {
+            set_classes(get<PaxTicket>(ar.ticket));
+        }
+        t.co2_empty = AircraftRoute::calc_co2(ac, cfg, full_distance, empty, ar.ci);
+        t.co2_full = AircraftRoute::calc_co2(ac, cfg, full_distance, full, ar.ci);
+    }
+    t.fixed_cost = ar.fuel * user.fuel_price / 1000.0 + ar.acheck_cost + ar.repair_cost;
+    t.co2_price = user.co2_price;
+    return t;
+}
+
+double AircraftRoute::LoadTerms::income(double load) const {
+    double income = 0;
+    for (const Class& c : this->classes) income += c.price * std::min(c.capacity * load, c.demand);
+    return income;
+}
+
+double AircraftRoute::LoadTerms::profit(double load) const {
+    const double co2 = this->co2_empty + (this->co2_full - this->co2_empty) * load;
+    return this->income(load) - co2 * this->co2_price / 1000.0 - this->fixed_cost;
+}
+
+double AircraftRoute::estimate_load(double reputation, double autoprice_ratio, bool has_stopover) {
     if (autoprice_ratio >
         1) {  // normal (sorta triangular?) distribution, [Z+(0: .00019, 1: .0068, 2: .0092), max: .001] * reputation
         if (has_stopover) {
@@ -356,7 +778,7 @@ inline double AircraftRoute::calc_fuel(const Aircraft& ac, double distance, cons
     );
 }
 
-inline double AircraftRoute::calc_co2(
+double AircraftRoute::calc_co2(
     const Aircraft& ac, const Aircraft::PaxConfig& cfg, double distance, const User& user, uint8_t ci
 ) {
     return (
@@ -367,7 +789,7 @@ inline double AircraftRoute::calc_co2(
     );
 }
 
-inline double AircraftRoute::calc_co2(
+double AircraftRoute::calc_co2(
     const Aircraft& ac, const Aircraft::CargoConfig& cfg, double distance, const User& user, uint8_t ci
 ) {
     return (
@@ -422,6 +844,8 @@ inline const string to_string(const AircraftRoute::Warning& warning) {
             return "ERR_INSUFFICIENT_DEMAND";
         case AircraftRoute::Warning::ERR_TRIPS_PER_DAY_TOO_HIGH:
             return "ERR_TRIPS_PER_DAY_TOO_HIGH";
+        case AircraftRoute::Warning::ERR_DISTANCE_BELOW_SPECIFIED:
+            return "ERR_DISTANCE_BELOW_SPECIFIED";
         default:
             return "[UNKNOWN]";
     }
@@ -469,25 +893,716 @@ const string AircraftRoute::repr(const AircraftRoute& ar) {
 Destination::Destination(const Airport& destination, const AircraftRoute& route)
     : airport(destination), ac_route(route) {}
 
-std::vector<Destination> RoutesSearch::get() const {
-    std::vector<Destination> destinations;
+CancellationToken::CancellationToken(std::optional<double> timeout)
+    : deadline(std::nullopt), flag(std::make_shared<std::atomic<bool>>(false)) {
+    if (timeout.has_value())
+        deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                      std::chrono::duration<double>(timeout.value())
+                                  );
+}
+
+void CancellationToken::cancel() { flag->store(true, std::memory_order_relaxed); }
+
+bool CancellationToken::cancelled() const {
+    if (flag->load(std::memory_order_relaxed)) return true;
+    return deadline.has_value() && Clock::now() >= deadline.value();
+}
+
+void parallel_for(size_t n, uint16_t threads, const std::function<void(size_t)>& fn) {
+    std::atomic<size_t> next{0};
+    std::exception_ptr error = nullptr;
+    std::mutex error_mtx;
+    auto worker = [&] {
+        for (size_t i = next++; i < n; i = next++) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mtx);
+                if (!error) error = std::current_exception();
+            }
+        }
+    };
+    const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    const size_t n_threads = std::max(size_t(1), std::min(n, threads == 0 ? hardware : threads));
+    vector<std::thread> pool;
+    for (size_t t = 1; t < n_threads; t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+    if (error) std::rethrow_exception(error);
+}
+
+double RoutesSearch::sort_value(const AircraftRoute& ar, AircraftRoute::Options::SortBy sort_by, uint32_t hub_cost) {
+    using SortBy = AircraftRoute::Options::SortBy;
+    const double tpd = static_cast<double>(ar.trips_per_day_per_ac);
+    switch (sort_by) {
+        case SortBy::PER_AC_PER_DAY:
+            return ar.profit * tpd;
+        case SortBy::PER_FLIGHT_HOUR:
+            return ar.profit / static_cast<double>(ar.flight_time);
+        case SortBy::CONTRIBUTION_PER_DAY:
+            return static_cast<double>(ar.contribution) * tpd;
+        case SortBy::PER_SEAT: {
+            double seats;
+            if (ar._ac_type == Aircraft::Type::CARGO) {
+                const auto& cfg = std::get<Aircraft::CargoConfig>(ar.config);
+                seats = static_cast<double>(cfg.l + cfg.h);
+            } else {
+                const auto& cfg = std::get<Aircraft::PaxConfig>(ar.config);
+                seats = static_cast<double>(cfg.y + cfg.j + cfg.f);
+            }
+            return ar.profit / std::max(1., seats);
+        }
+        case SortBy::INCOME:
+            return ar.income;
+        case SortBy::PER_DAY_AFTER_HUB_COST:
+            return ar.profit * tpd - static_cast<double>(hub_cost) / HUB_COST_AMORTISATION_DAYS;
+        case SortBy::FLIGHT_TIME:
+            return -static_cast<double>(ar.flight_time);
+        default:
+            return ar.profit;
+    }
+}
+
+bool RoutesSearch::ranks_before(const Destination& a, const Destination& b) const {
+    auto compare = [&](AircraftRoute::Options::SortBy sort_by) {
+        const double va = sort_value(a.ac_route, sort_by, a.airport.hub_cost);
+        const double vb = sort_value(b.ac_route, sort_by, b.airport.hub_cost);
+        return va > vb ? 1 : (va < vb ? -1 : 0);
+    };
+    int c = compare(this->options.sort_by);
+    for (auto it = this->options.then_by.begin(); c == 0 && it != this->options.then_by.end(); it++) c = compare(*it);
+    if (c != 0) return c > 0;
+    return a.airport.id < b.airport.id;
+}
+
+void RoutesSearch::sort_destinations(std::vector<Destination>& destinations) const {
+    std::sort(destinations.begin(), destinations.end(), [this](const Destination& a, const Destination& b) {
+        return this->ranks_before(a, b);
+    });
+}
+
+vector<Destination> RoutesSearch::reprice(
+    vector<Destination> destinations, uint16_t fuel_price, uint8_t co2_price
+) const {
+    for (Destination& d : destinations) d.ac_route.reprice(fuel_price, co2_price);
+    this->sort_destinations(destinations);
+    return destinations;
+}
+
+RoutesSearch::Filter::Filter(
+    uint16_t min_rwy,
+    uint8_t min_market,
+    uint32_t max_hub_cost,
+    const vector<string>& continents,
+    const vector<string>& countries,
+    const vector<uint16_t>& exclude_ids
+)
+    : min_rwy(min_rwy),
+      min_market(min_market),
+      max_hub_cost(max_hub_cost),
+      continents(continents),
+      countries(countries),
+      exclude_ids(exclude_ids) {}
+
+inline string trim(const string& s) {
+    const size_t first = s.find_first_not_of(" \t");
+    if (first == string::npos) return "";
+    return s.substr(first, s.find_last_not_of(" \t") - first + 1);
+}
+
+inline vector<string> split(const string& s, char sep) {
+    vector<string> parts;
+    size_t start = 0;
+    while (true) {
+        const size_t end = s.find(sep, start);
+        const string part = trim(s.substr(start, end == string::npos ? string::npos : end - start));
+        if (!part.empty()) parts.push_back(part);
+        if (end == string::npos) break;
+        start = end + 1;
+    }
+    return parts;
+}
+
+inline string uppercase(string s) {
+    std::transform(s.begin(), s.end(), s.begin(), ::toupper);
+    return s;
+}
+
+RoutesSearch::Filter RoutesSearch::Filter::parse(const string& expr) {
+    Filter f;
+    for (const string& clause : split(expr, ';')) {
+        const size_t op_start = clause.find_first_of("<>=");
+        if (op_start == string::npos) throw InvalidFilterException("Filter clause `" + clause + "` has no operator.");
+        const size_t op_end = clause.find_first_not_of("<>=", op_start);
+        const string field = uppercase(trim(clause.substr(0, op_start)));
+        const string op = clause.substr(op_start, op_end == string::npos ? string::npos : op_end - op_start);
+        const vector<string> values = op_end == string::npos ? vector<string>() : split(clause.substr(op_end), ',');
+        if (values.empty()) throw InvalidFilterException("Filter clause `" + clause + "` has no value.");
+
+        auto expect = [&](const string& expected, bool many = false) {
+            if (op != expected)
+                throw InvalidFilterException("Filter clause `" + clause + "`: expected operator `" + expected + "`.");
+            if (!many && values.size() != 1)
+                throw InvalidFilterException("Filter clause `" + clause + "`: expected a single value.");
+        };
+        auto to_uint = [&](const string& value, uint32_t max) {
+            try {
+                size_t pos;
+                const unsigned long n = std::stoul(value, &pos);
+                if (pos == value.size() && value[0] != '-' && n <= max) return static_cast<uint32_t>(n);
+            } catch (std::logic_error&) {
+            }
+            throw InvalidFilterException("Filter clause `" + clause + "`: `" + value + "` is not a valid number.");
+        };
+
+        if (field == "CONTINENT") {
+            expect("=", true);
+            f.continents.insert(f.continents.end(), values.begin(), values.end());
+        } else if (field == "COUNTRY") {
+            expect("=", true);
+            f.countries.insert(f.countries.end(), values.begin(), values.end());
+        } else if (field == "MARKET") {
+            expect(">=");
+            f.min_market = static_cast<uint8_t>(to_uint(values[0], std::numeric_limits<uint8_t>::max()));
+        } else if (field == "RWY") {
+            expect(">=");
+            f.min_rwy = static_cast<uint16_t>(to_uint(values[0], std::numeric_limits<uint16_t>::max()));
+        } else if (field == "HUB_COST") {
+            expect("<=");
+            f.max_hub_cost = to_uint(values[0], std::numeric_limits<uint32_t>::max());
+        } else if (field == "EXCLUDE") {
+            expect("=", true);
+            for (const string& v : values)
+                f.exclude_ids.push_back(static_cast<uint16_t>(to_uint(v, std::numeric_limits<uint16_t>::max())));
+        } else {
+            throw InvalidFilterException(
+                "Filter clause `" + clause + "`: unknown field, expected one of continent, country, market, rwy, "
+                "hub_cost or exclude."
+            );
+        }
+    }
+    return f;
+}
+
+bool RoutesSearch::Filter::empty() const {
+    return min_rwy == 0 && min_market == 0 && max_hub_cost == std::numeric_limits<uint32_t>::max() &&
+           continents.empty() && countries.empty() && exclude_ids.empty();
+}
+
+vector<uint8_t> RoutesSearch::Filter::compile() const {
+    const auto& db = Database::Client();
+    const auto& c = db->airport_columns;
+
+    // resolve the names against the column dictionaries once, so the per-airport test is a table lookup
+    auto lookup = [](const vector<string>& dictionary, const vector<string>& wanted) {
+        vector<uint8_t> allowed(dictionary.size(), wanted.empty());
+        for (const string& w : wanted) {
+            const string w_upper = uppercase(w);
+            for (size_t i = 0; i < dictionary.size(); i++) {
+                if (uppercase(dictionary[i]) == w_upper) allowed[i] = 1;
+            }
+        }
+        return allowed;
+    };
+    const vector<uint8_t> continent_ok = lookup(c.continent_names, continents);
+    const vector<uint8_t> country_ok = lookup(c.country_names, countries);
+    vector<uint8_t> excluded(AIRPORT_ID_MAX + 1, 0);  // bitmap over airport ids
+    for (uint16_t id : exclude_ids) {
+        if (id <= AIRPORT_ID_MAX) excluded[id] = 1;
+    }
+
+    vector<uint8_t> mask(AIRPORT_COUNT);
+    for (uint16_t i = 0; i < AIRPORT_COUNT; i++) {
+        mask[i] = c.rwy[i] >= min_rwy && c.market[i] >= min_market && c.hub_cost[i] <= max_hub_cost &&
+                  continent_ok[c.continent[i]] && country_ok[c.country[i]] && !excluded[c.id[i]];
+    }
+    return mask;
+}
+
+vector<uint16_t> RoutesSearch::candidates() const {
     const auto& db = Database::Client();
+    const uint16_t o_idx = db->airport_id_hashtable[this->origin.id];
+    const vector<uint16_t>& neighbours = db->get_neighbours(o_idx);
+    const double* distances = db->distances[o_idx];
 
+    // mirrors the distance checks in AircraftRoute::create
+    const double lo = std::max(100., this->options.min_distance);
+    const double hi = std::min(this->options.max_distance, 2. * this->aircraft.range);
+    auto first = std::lower_bound(neighbours.begin(), neighbours.end(), lo, [distances](uint16_t idx, double d) {
+        return distances[idx] < d;
+    });
+    auto last = std::upper_bound(first, neighbours.end(), hi, [distances](double d, uint16_t idx) {
+        return d < distances[idx];
+    });
+    if (this->filter.empty()) return vector<uint16_t>(first, last);
+
+    const vector<uint8_t> allowed = this->filter.compile();
+    vector<uint16_t> idxs;
+    idxs.reserve(static_cast<size_t>(last - first));
+    for (auto it = first; it != last; it++) {
+        if (allowed[*it]) idxs.push_back(*it);
+    }
+    return idxs;
+}
+
+void RoutesSearch::evaluate(const uint16_t* first, const uint16_t* last, vector<Destination>& out) const {
+    const auto& db = Database::Client();
+    const uint16_t* rwy = db->airport_columns.rwy;
     const uint16_t rwy_requirement = this->user.game_mode == User::GameMode::EASY ? 0 : this->aircraft.rwy;
-    for (const Airport& ap : db->airports) {
-        if (ap.rwy < rwy_requirement || ap.id == this->origin.id) continue;
-        const AircraftRoute ar = AircraftRoute::create(this->origin, ap, this->aircraft, this->options, this->user);
+    const auto create = AircraftRoute::kernel(this->aircraft.type, this->user.game_mode, this->options.tpd_mode);
+    for (const uint16_t* it = first; it != last; it++) {
+        if (rwy[*it] < rwy_requirement) continue;
+        const Airport& ap = db->airports[*it];
+        const AircraftRoute ar = create(this->origin, ap, this->aircraft, this->options, this->user, nullptr);
         if (!ar.valid) continue;
-        destinations.emplace_back(ap, ar);
-    }
-    auto cmp = this->options.sort_by == AircraftRoute::Options::SortBy::PER_TRIP
-                   ? [](const Destination& a, const Destination& b) { return a.ac_route.profit > b.ac_route.profit; }
-                   : [](const Destination& a, const Destination& b) {
-                         return a.ac_route.profit * a.ac_route.trips_per_day_per_ac >
-                                b.ac_route.profit * b.ac_route.trips_per_day_per_ac;
-                     };
-    std::sort(destinations.begin(), destinations.end(), cmp);
-    return destinations;
+        out.emplace_back(ap, ar);
+    }
+}
+
+template <typename T>
+inline void append_bytes(string& s, const T& v) {
+    s.append(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <typename T>
+inline void append_bytes(string& s, const vector<T>& v) {
+    append_bytes(s, v.size());
+    for (const T& e : v) append_bytes(s, e);
+}
+
+template <>
+inline void append_bytes(string& s, const string& v) {
+    append_bytes(s, v.size());
+    s.append(v);
+}
+
+string RoutesSearch::key() const {
+    string k;
+    k.reserve(96);
+    append_bytes(k, this->origin.id);
+
+    // the effective (post-modification) values rather than the mod flags, so equivalent aircraft share a key
+    const Aircraft& ac = this->aircraft;
+    append_bytes(k, ac.id);
+    append_bytes(k, ac.type);
+    append_bytes(k, ac.speed);
+    append_bytes(k, ac.fuel);
+    append_bytes(k, ac.co2);
+    append_bytes(k, ac.cost);
+    append_bytes(k, ac.capacity);
+    append_bytes(k, ac.rwy);
+    append_bytes(k, ac.check_cost);
+    append_bytes(k, ac.range);
+    append_bytes(k, ac.maint);
+
+    const AircraftRoute::Options& o = this->options;
+    append_bytes(k, o.tpd_mode);
+    append_bytes(k, o.trips_per_day_per_ac);
+    append_bytes(k, o.max_distance);
+    append_bytes(k, o.min_distance);
+    append_bytes(k, o.max_flight_time);
+    append_bytes(k, o.sort_by);
+    append_bytes(k, o.then_by);
+    append_bytes(k, o.ci_objective);
+    append_bytes(k, o.demand_layer ? o.demand_layer->version : uint64_t(0));
+    const auto overlay = o.demand_overlay.entries();
+    append_bytes(k, overlay.size());
+    for (const auto& [route_idx, used] : overlay) {
+        append_bytes(k, route_idx);
+        append_bytes(k, used.y);
+        append_bytes(k, used.j);
+        append_bytes(k, used.f);
+    }
+    const size_t cfg_idx = o.config_algorithm.index();
+    append_bytes(k, cfg_idx);
+    if (cfg_idx == 1) append_bytes(k, std::get<Aircraft::PaxConfig::Algorithm>(o.config_algorithm));
+    if (cfg_idx == 2) append_bytes(k, std::get<Aircraft::CargoConfig::Algorithm>(o.config_algorithm));
+
+    const User& u = this->user;
+    append_bytes(k, u.game_mode);
+    append_bytes(k, u.wear_training);
+    append_bytes(k, u.repair_training);
+    append_bytes(k, u.l_training);
+    append_bytes(k, u.h_training);
+    append_bytes(k, u.fuel_training);
+    append_bytes(k, u.co2_training);
+    append_bytes(k, u.fuel_price);
+    append_bytes(k, u.co2_price);
+    append_bytes(k, u.load);
+    append_bytes(k, u.income_loss_tol);
+
+    const Filter& f = this->filter;
+    append_bytes(k, f.min_rwy);
+    append_bytes(k, f.min_market);
+    append_bytes(k, f.max_hub_cost);
+    append_bytes(k, f.continents);
+    append_bytes(k, f.countries);
+    append_bytes(k, f.exclude_ids);
+    return k;
+}
+
+std::vector<Destination> RoutesSearch::get() const { return this->run(CancellationToken()).destinations; }
+
+RoutesSearch::Result RoutesSearch::run(const CancellationToken& token, const ChunkCallback& on_chunk) const {
+    Result result;
+    const vector<uint16_t> idxs = this->candidates();
+    const uint16_t total = static_cast<uint16_t>(idxs.size());
+    vector<Destination> chunk;
+    for (uint16_t chunk_start = 0; chunk_start < total; chunk_start += CHUNK_SIZE) {
+        if (token.cancelled()) {
+            result.truncated = true;
+            break;
+        }
+        const uint16_t chunk_end = std::min(static_cast<uint16_t>(chunk_start + CHUNK_SIZE), total);
+        if (on_chunk) {
+            chunk.clear();
+            this->evaluate(idxs.data() + chunk_start, idxs.data() + chunk_end, chunk);
+            on_chunk(chunk);
+            result.destinations.insert(result.destinations.end(), chunk.begin(), chunk.end());
+        } else {
+            this->evaluate(idxs.data() + chunk_start, idxs.data() + chunk_end, result.destinations);
+        }
+        result.evaluated = chunk_end;
+    }
+    this->sort_destinations(result.destinations);
+    return result;
+}
+
+/*
+An upper bound of sort_value() for the destination that only needs the direct distance, the ticket prices, the aircraft
+capacity and the raw demand. With a valid config, no class holds more than its per-trip demand and the seats used
+never exceed the capacity, so the income per trip is bounded by both. Every cost is non-negative and non-decreasing
+in distance, and a stopover can only lengthen the trip, so the direct distance gives a lower bound of the costs.
+*/
+double RoutesSearch::sort_value_upper_bound(uint16_t o_idx, uint16_t d_idx) const {
+    const auto& db = Database::Client();
+    const Aircraft& ac = this->aircraft;
+    const User& user = this->user;
+    const double distance = db->distances[o_idx][d_idx];
+    // before the demand overlay is taken off, which can only lower it
+    const PaxDemand pd = db->demand_provider.get(o_idx, d_idx, this->options.demand_layer.get());
+    const double capacity = static_cast<double>(ac.capacity);
+    // a lower ci only ever cuts fuel and co2, so the bound uses the cheapest ci the route may end up flying at
+    const uint8_t min_ci = this->options.ci_objective == AircraftRoute::Options::CIObjective::NONE ? 200 : 0;
+
+    double income_per_trip;  // capacity limited
+    double income_per_day;   // demand limited, over all trips of all aircraft
+    double co2;
+    if (ac.type == Aircraft::Type::CARGO) {
+        const CargoDemand cd(pd);
+        const CargoTicket tkt = CargoTicket::from_optimal(distance, user.game_mode);
+        const double l_yield = (1 + user.l_training / 100.0) * 0.7 * tkt.l;
+        const double h_yield = (1 + user.h_training / 100.0) * tkt.h;
+        income_per_trip = user.load * capacity * std::max(l_yield, h_yield);
+        income_per_day = static_cast<double>(cd.l) * tkt.l + static_cast<double>(cd.h) * tkt.h;
+
+        Aircraft::CargoConfig cfg;  // all-large emits the least co2 for a fully loaded aircraft
+        cfg.l = 100;
+        cfg.h = 0;
+        co2 = AircraftRoute::calc_co2(ac, cfg, distance, user, min_ci);
+    } else {
+        double ty, tj, tf;
+        if (ac.type == Aircraft::Type::VIP) {
+            const VIPTicket tkt = VIPTicket::from_optimal(distance, user.game_mode);
+            ty = tkt.y, tj = tkt.j, tf = tkt.f;
+        } else {
+            const PaxTicket tkt = PaxTicket::from_optimal(distance, user.game_mode);
+            ty = tkt.y, tj = tkt.j, tf = tkt.f;
+        }
+        income_per_trip = user.load * capacity * std::max({ty, tj / 2, tf / 3});
+        income_per_day = pd.y * ty + pd.j * tj + pd.f * tf;
+
+        // every config algorithm leaves at most 2 seat units unused, and all-first minimises the number of pax
+        const double seat_units = std::max(0., capacity - 2);
+        co2 = (1 - user.co2_training / 100.0) *
+              (ceil(distance * 100.0) / 100.0 * ac.co2 * seat_units * user.load + seat_units / 3) *
+              (min_ci / 2000.0 + 0.9);
+    }
+
+    const bool easy = user.game_mode == User::GameMode::EASY;
+    const float flight_time = static_cast<float>(distance) / (ac.speed * (easy ? 1.5f : 1.0f));
+    const double acheck_cost = static_cast<float>(ac.check_cost * (easy ? 0.5 : 1.0)) *
+                               ceil(flight_time * (easy ? 1.5 : 1.0)) / static_cast<float>(ac.maint);
+    const double repair_cost = ac.cost / 1000.0 * 0.0075 * (1 - 2 * user.repair_training / 100.0);
+    const double cost = AircraftRoute::calc_fuel(ac, distance, user, min_ci) * user.fuel_price / 1000.0 +
+                        co2 * user.co2_price / 1000.0 + acheck_cost + repair_cost;
+
+    const double income = std::min(income_per_trip, income_per_day);
+    const double per_trip = income - cost;
+    // profit * tpd <= min(tpd * income_per_trip, income_per_day) - tpd * cost, with tpd >= 1
+    const double max_tpd = this->options.tpd_mode == AircraftRoute::Options::TPDMode::AUTO
+                               ? floor(24. / static_cast<double>(flight_time))
+                               : static_cast<double>(this->options.trips_per_day_per_ac);
+    const double per_day = std::min(max_tpd * income_per_trip, income_per_day) - cost;
+
+    using SortBy = AircraftRoute::Options::SortBy;
+    switch (this->options.sort_by) {
+        case SortBy::PER_TRIP:
+            return per_trip;
+        case SortBy::PER_AC_PER_DAY:
+            return per_day;
+        case SortBy::PER_FLIGHT_HOUR: {
+            // the flight time lies between the direct one and max_flight_time, pick whichever maximises the ratio
+            const float max_flight_time = std::max(flight_time, this->options.max_flight_time);
+            return per_trip / static_cast<double>(per_trip >= 0 ? flight_time : max_flight_time);
+        }
+        case SortBy::INCOME:
+            return income;
+        case SortBy::PER_DAY_AFTER_HUB_COST:
+            return per_day - static_cast<double>(db->airport_columns.hub_cost[d_idx]) / HUB_COST_AMORTISATION_DAYS;
+        case SortBy::FLIGHT_TIME:
+            return -static_cast<double>(flight_time);
+        default:
+            // contribution depends on the stopover and the seats on the config: no cheap bound, so never prune
+            return std::numeric_limits<double>::infinity();
+    }
+}
+
+vector<Destination> RoutesSearch::top_k(uint16_t k) const {
+    vector<Destination> best;
+    if (k == 0) return best;
+    const auto& db = Database::Client();
+    const uint16_t o_idx = db->airport_id_hashtable[this->origin.id];
+    const uint16_t rwy_requirement = this->user.game_mode == User::GameMode::EASY ? 0 : this->aircraft.rwy;
+
+    struct Candidate {
+        double bound;
+        uint16_t idx;
+    };
+    vector<Candidate> candidates;
+    for (uint16_t idx : this->candidates()) {
+        if (db->airport_columns.rwy[idx] < rwy_requirement) continue;
+        candidates.push_back({sort_value_upper_bound(o_idx, idx), idx});
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.bound > b.bound;
+    });
+
+    const auto create = AircraftRoute::kernel(this->aircraft.type, this->user.game_mode, this->options.tpd_mode);
+    // max-heap on "worst first", so best.front() is the current k-th best
+    auto cmp = [this](const Destination& a, const Destination& b) { return this->ranks_before(a, b); };
+    best.reserve(k);
+    for (const Candidate& c : candidates) {
+        if (best.size() == k) {
+            // slack for floating point differences between the bound and the full evaluation. on an exact tie the
+            // candidate can still win on airport id, so only stop once it is strictly worse.
+            const double slack = 1e-6 * std::abs(c.bound) + 1e-3;
+            const Destination& kth = best.front();
+            if (c.bound + slack < sort_value(kth.ac_route, this->options.sort_by, kth.airport.hub_cost)) break;
+        }
+        const Airport& ap = db->airports[c.idx];
+        const AircraftRoute ar = create(this->origin, ap, this->aircraft, this->options, this->user, nullptr);
+        if (!ar.valid) continue;
+        const Destination dest(ap, ar);
+        if (best.size() < k) {
+            best.push_back(dest);
+            std::push_heap(best.begin(), best.end(), cmp);
+        } else if (cmp(dest, best.front())) {
+            std::pop_heap(best.begin(), best.end(), cmp);
+            best.back() = dest;
+            std::push_heap(best.begin(), best.end(), cmp);
+        }
+    }
+    this->sort_destinations(best);
+    return best;
+}
+
+RoutesSearch::Result RoutesSearch::pareto(
+    const vector<AircraftRoute::Options::SortBy>& objectives, const CancellationToken& token
+) const {
+    if (objectives.empty()) throw std::invalid_argument("At least one objective is required.");
+    const size_t m = objectives.size();
+    Result result;
+    vector<Destination>& window = result.destinations;
+    vector<double> window_values;  // row-major, m values per destination in the window
+
+    // true if every value of `a` is at least that of `b` and one is strictly greater
+    auto dominates = [m](const double* a, const double* b) {
+        bool strictly = false;
+        for (size_t i = 0; i < m; i++) {
+            if (a[i] < b[i]) return false;
+            if (a[i] > b[i]) strictly = true;
+        }
+        return strictly;
+    };
+
+    const vector<uint16_t> idxs = this->candidates();
+    const uint16_t total = static_cast<uint16_t>(idxs.size());
+    vector<Destination> chunk;
+    vector<double> values(m);
+    for (uint16_t chunk_start = 0; chunk_start < total; chunk_start += CHUNK_SIZE) {
+        if (token.cancelled()) {
+            result.truncated = true;
+            break;
+        }
+        const uint16_t chunk_end = std::min(static_cast<uint16_t>(chunk_start + CHUNK_SIZE), total);
+        chunk.clear();
+        this->evaluate(idxs.data() + chunk_start, idxs.data() + chunk_end, chunk);
+        for (const Destination& d : chunk) {
+            for (size_t i = 0; i < m; i++) values[i] = sort_value(d.ac_route, objectives[i], d.airport.hub_cost);
+
+            // compacts the window in place, dropping every entry the new destination dominates. the window is
+            // mutually non-dominated, so if an entry dominates the new destination, the new one cannot have
+            // dominated (and dropped) anything before it: the window is still intact when we bail out.
+            bool dominated = false;
+            size_t kept = 0;
+            for (size_t w = 0; w < window.size(); w++) {
+                const double* wv = window_values.data() + w * m;
+                if (dominates(wv, values.data())) {
+                    dominated = true;
+                    break;
+                }
+                if (dominates(values.data(), wv)) continue;
+                if (kept != w) {
+                    window[kept] = window[w];
+                    std::copy(wv, wv + m, window_values.begin() + static_cast<std::ptrdiff_t>(kept * m));
+                }
+                kept++;
+            }
+            if (dominated) continue;
+            window.erase(window.begin() + static_cast<std::ptrdiff_t>(kept), window.end());
+            window_values.resize(kept * m);
+            window.push_back(d);
+            window_values.insert(window_values.end(), values.begin(), values.end());
+        }
+        result.evaluated = chunk_end;
+    }
+    this->sort_destinations(window);
+    return result;
+}
+
+shared_ptr<RoutesSearch::Stream> RoutesSearch::stream(uint16_t top_k) const {
+    return std::make_shared<Stream>(*this, top_k);
+}
+
+RoutesSearch::Stream::Stream(const RoutesSearch& search, uint16_t top_k)
+    : search(search), top_k(top_k), idxs(search.candidates()), _evaluated(0) {}
+
+vector<Destination> RoutesSearch::Stream::next_chunk() {
+    vector<Destination> chunk;
+    const uint16_t chunk_start = this->evaluated();
+    const uint16_t total = this->total();
+    if (chunk_start >= total) return chunk;
+    const uint16_t chunk_end = std::min(static_cast<uint16_t>(chunk_start + CHUNK_SIZE), total);
+    this->search.evaluate(idxs.data() + chunk_start, idxs.data() + chunk_end, chunk);
+
+    auto cmp = [this](const Destination& a, const Destination& b) { return this->search.ranks_before(a, b); };
+    std::lock_guard<std::mutex> lock(mtx);
+    _top.insert(_top.end(), chunk.begin(), chunk.end());
+    if (top_k > 0 && _top.size() > top_k) {
+        std::partial_sort(_top.begin(), _top.begin() + top_k, _top.end(), cmp);
+        _top.erase(_top.begin() + top_k, _top.end());
+    } else {
+        std::sort(_top.begin(), _top.end(), cmp);
+    }
+    _evaluated = chunk_end;
+    return chunk;
+}
+
+bool RoutesSearch::Stream::done() const { return this->evaluated() >= this->total(); }
+
+uint16_t RoutesSearch::Stream::total() const { return static_cast<uint16_t>(idxs.size()); }
+
+uint16_t RoutesSearch::Stream::evaluated() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return _evaluated;
+}
+
+vector<Destination> RoutesSearch::Stream::top() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return _top;
+}
+
+AircraftSearch::AircraftSearch(
+    const Airport& origin,
+    const Airport& destination,
+    const AircraftRoute::Options& options,
+    const User& user,
+    bool include_mods,
+    uint16_t threads
+)
+    : origin(origin),
+      destination(destination),
+      options(options),
+      user(user),
+      include_mods(include_mods),
+      threads(threads) {}
+
+/*
+Every aircraft x mods variant of Database::aircraft_variants is one job. The mods never change the range or the runway
+requirement, so the stopovers are found first, one per distinct (range, runway) class among the variants that need
+one, and the variants only read them. The pair's distance and demand are single table reads, and the tickets only
+depend on the distance.
+*/
+vector<AircraftSearch::Candidate> AircraftSearch::top_k(uint16_t k) const {
+    using Stopover = AircraftRoute::Stopover;
+    const auto& db = Database::Client();
+    const double distance = Route::create(this->origin, this->destination).direct_distance;
+    const bool easy = this->user.game_mode == User::GameMode::EASY;
+
+    const uint8_t n_mods = this->include_mods ? 8 : 1;
+    vector<const Aircraft*> variants;
+    variants.reserve(AIRCRAFT_COUNT * n_mods);
+    for (uint16_t i = 0; i < AIRCRAFT_COUNT; i++) {
+        for (uint8_t mods = 0; mods < n_mods; mods++) {
+            const uint8_t variant = Aircraft::mods_variant(mods & 1, mods & 2, mods & 4, this->user.fourx);
+            variants.push_back(&db->aircraft_variants[i][variant]);
+        }
+    }
+
+    using StopoverClass = std::pair<uint16_t, uint16_t>;
+    auto class_of = [&](const Aircraft& ac) { return StopoverClass(ac.range, easy ? uint16_t(0) : ac.rwy); };
+    std::map<StopoverClass, Stopover> stopovers;
+    for (const Aircraft* ac : variants) {
+        if (distance > ac->range && distance <= 2 * ac->range) stopovers[class_of(*ac)] = Stopover();
+    }
+    vector<std::map<StopoverClass, Stopover>::iterator> classes;
+    for (auto it = stopovers.begin(); it != stopovers.end(); it++) classes.push_back(it);
+    parallel_for(classes.size(), this->threads, [&](size_t i) {
+        Aircraft ac;
+        ac.range = classes[i]->first.first;
+        ac.rwy = classes[i]->first.second;
+        classes[i]->second = Stopover::find_by_efficiency(this->origin, this->destination, ac, this->user.game_mode);
+    });
+
+    // a variant that needs a stopover always finds its class above, a found or a missing one alike. one that cannot
+    // reach the destination even with a stopover is left invalid without evaluating it.
+    vector<AircraftRoute> routes(variants.size());
+    parallel_for(variants.size(), this->threads, [&](size_t i) {
+        const Aircraft& ac = *variants[i];
+        if (distance > 2 * ac.range) return;
+        auto it = stopovers.find(class_of(ac));
+        const Stopover* stopover = it == stopovers.end() ? nullptr : &it->second;
+        routes[i] = AircraftRoute::kernel(ac.type, this->user.game_mode, this->options.tpd_mode)(
+            this->origin, this->destination, ac, this->options, this->user, stopover
+        );
+    });
+
+    vector<AircraftRoute::Options::SortBy> keys = {this->options.sort_by};
+    keys.insert(keys.end(), this->options.then_by.begin(), this->options.then_by.end());
+    vector<uint32_t> order;
+    vector<vector<double>> values(keys.size(), vector<double>(variants.size()));
+    for (uint32_t i = 0; i < variants.size(); i++) {
+        if (!routes[i].valid) continue;
+        order.push_back(i);
+        for (size_t j = 0; j < keys.size(); j++) {
+            values[j][i] = RoutesSearch::sort_value(routes[i], keys[j], this->destination.hub_cost);
+        }
+    }
+    // the variants are in database order, then by mods: the index breaks the remaining ties
+    auto ranks_before = [&](uint32_t a, uint32_t b) {
+        for (const vector<double>& v : values) {
+            if (v[a] != v[b]) return v[a] > v[b];
+        }
+        return a < b;
+    };
+    const size_t n = k == 0 ? order.size() : std::min(order.size(), size_t(k));
+    std::partial_sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(n), order.end(), ranks_before);
+
+    vector<Candidate> candidates;
+    candidates.reserve(n);
+    for (size_t i = 0; i < n; i++) candidates.emplace_back(*variants[order[i]], routes[order[i]]);
+    return candidates;
 }
 
 #if BUILD_PYBIND == 1
@@ -513,6 +1628,19 @@ py::list to_list(const vector<AircraftRoute::Warning>& warnings) {
     return l;
 }
 
+py::dict to_dict(const AircraftRoute::TPDPoint& p) {
+    py::dict d(
+        "trips_per_day_per_ac"_a = p.trips_per_day_per_ac, "num_ac"_a = p.num_ac, "income"_a = p.income,
+        "co2"_a = p.co2, "profit"_a = p.profit
+    );
+    if (std::holds_alternative<Aircraft::PaxConfig>(p.config)) {
+        d["config"] = to_dict(get<Aircraft::PaxConfig>(p.config));
+    } else {
+        d["config"] = to_dict(get<Aircraft::CargoConfig>(p.config));
+    }
+    return d;
+}
+
 py::dict to_dict(const AircraftRoute& ar) {
     py::dict d(
         "route"_a = to_dict(ar.route), "warnings"_a = to_list(ar.warnings), "valid"_a = false, "max_tpd"_a = ar.max_tpd
@@ -577,6 +1705,10 @@ py::dict to_dict(const Destination& d) {
     return py::dict("airport"_a = to_dict(d.airport), "ac_route"_a = to_dict(d.ac_route));
 }
 
+py::dict to_dict(const AircraftSearch::Candidate& c) {
+    return py::dict("aircraft"_a = to_dict(c.aircraft), "ac_route"_a = to_dict(c.ac_route));
+}
+
 std::map<string, py::list> _get_columns(const RoutesSearch& rs, const vector<Destination>& dests) {
     // for use in csv generation via pyarrow.Table.from_pydict & downstream statistical analysis
     // assuming dests to be all valid
@@ -649,9 +1781,25 @@ std::map<string, py::list> _get_columns(const RoutesSearch& rs, const vector<Des
 void pybind_init_route(py::module_& m) {
     py::module_ m_route = m.def_submodule("route");
 
+    py::class_<DemandOverlay>(m_route, "DemandOverlay")
+        .def(py::init<>())
+        .def(
+            "consume", py::overload_cast<uint32_t, const PaxDemand&>(&DemandOverlay::consume), "route_idx"_a, "demand"_a
+        )
+        .def(
+            "consume", py::overload_cast<const Airport&, const Airport&, const PaxDemand&>(&DemandOverlay::consume),
+            "ap0"_a, "ap1"_a, "demand"_a
+        )
+        .def("consume_route_list", &DemandOverlay::consume_route_list, "routes"_a, "per_route"_a)
+        .def("consumed", &DemandOverlay::consumed, "route_idx"_a)
+        .def("remaining", &DemandOverlay::remaining, "route_idx"_a, "full"_a)
+        .def("entries", &DemandOverlay::entries)
+        .def("__len__", &DemandOverlay::size);
+
     py::class_<AircraftRoute> acr_class(m_route, "AircraftRoute");
 
     py::register_exception<SameOdException>(m_route, "SameOdException");
+    py::register_exception<InvalidFilterException>(m_route, "InvalidFilterException");
 
     py::class_<Route>(m_route, "Route")
         .def_readonly("pax_demand", &Route::pax_demand)
@@ -675,22 +1823,65 @@ void pybind_init_route(py::module_& m) {
         .value("STRICT", AircraftRoute::Options::TPDMode::STRICT);
     py::enum_<AircraftRoute::Options::SortBy>(acr_options_class, "SortBy")
         .value("PER_TRIP", AircraftRoute::Options::SortBy::PER_TRIP)
-        .value("PER_AC_PER_DAY", AircraftRoute::Options::SortBy::PER_AC_PER_DAY);
+        .value("PER_AC_PER_DAY", AircraftRoute::Options::SortBy::PER_AC_PER_DAY)
+        .value("PER_FLIGHT_HOUR", AircraftRoute::Options::SortBy::PER_FLIGHT_HOUR)
+        .value("CONTRIBUTION_PER_DAY", AircraftRoute::Options::SortBy::CONTRIBUTION_PER_DAY)
+        .value("PER_SEAT", AircraftRoute::Options::SortBy::PER_SEAT)
+        .value("INCOME", AircraftRoute::Options::SortBy::INCOME)
+        .value("PER_DAY_AFTER_HUB_COST", AircraftRoute::Options::SortBy::PER_DAY_AFTER_HUB_COST)
+        .value("FLIGHT_TIME", AircraftRoute::Options::SortBy::FLIGHT_TIME);
+    py::enum_<AircraftRoute::Options::CIObjective>(acr_options_class, "CIObjective")
+        .value("NONE", AircraftRoute::Options::CIObjective::NONE)
+        .value("PER_AC_PER_DAY", AircraftRoute::Options::CIObjective::PER_AC_PER_DAY)
+        .value("CONTRIBUTION_PER_DAY", AircraftRoute::Options::CIObjective::CONTRIBUTION_PER_DAY);
     acr_options_class
         .def(
             py::init<
                 AircraftRoute::Options::TPDMode, uint16_t, double, double, AircraftRoute::Options::ConfigAlgorithm,
-                AircraftRoute::Options::SortBy>(),
+                AircraftRoute::Options::SortBy, double, const vector<AircraftRoute::Options::SortBy>&,
+                AircraftRoute::Options::CIObjective, const DemandOverlay&>(),
             py::arg_v("tpd_mode", AircraftRoute::Options::TPDMode::AUTO, "TPDMode.AUTO"), "trips_per_day_per_ac"_a = 1,
             "max_distance"_a = MAX_DISTANCE, "max_flight_time"_a = 24.0f, "config_algorithm"_a = std::monostate(),
-            py::arg_v("sort_by", AircraftRoute::Options::SortBy::PER_TRIP, "SortBy.PER_TRIP")
+            py::arg_v("sort_by", AircraftRoute::Options::SortBy::PER_TRIP, "SortBy.PER_TRIP"), "min_distance"_a = 0.0,
+            "then_by"_a = vector<AircraftRoute::Options::SortBy>(),
+            py::arg_v("ci_objective", AircraftRoute::Options::CIObjective::NONE, "CIObjective.NONE"),
+            py::arg_v("demand_overlay", DemandOverlay(), "am4.utils.route.DemandOverlay()")
         )
         .def_readwrite("tpd_mode", &AircraftRoute::Options::tpd_mode)
         .def_readwrite("trips_per_day_per_ac", &AircraftRoute::Options::trips_per_day_per_ac)
         .def_readwrite("max_distance", &AircraftRoute::Options::max_distance)
+        .def_readwrite("min_distance", &AircraftRoute::Options::min_distance)
         .def_readwrite("max_flight_time", &AircraftRoute::Options::max_flight_time)
         .def_readwrite("config_algorithm", &AircraftRoute::Options::config_algorithm)
-        .def_readwrite("sort_by", &AircraftRoute::Options::sort_by);
+        .def_readwrite("sort_by", &AircraftRoute::Options::sort_by)
+        .def_readwrite("then_by", &AircraftRoute::Options::then_by)
+        .def_readwrite("ci_objective", &AircraftRoute::Options::ci_objective)
+        .def_readwrite("demand_overlay", &AircraftRoute::Options::demand_overlay)
+        .def_property(
+            "demand_layer",
+            [](const AircraftRoute::Options& o) { return std::const_pointer_cast<DemandLayer>(o.demand_layer); },
+            [](AircraftRoute::Options& o, shared_ptr<DemandLayer> layer) { o.demand_layer = layer; }
+        );
+
+    py::class_<AircraftRoute::TPDPoint>(acr_class, "TPDPoint")
+        .def_readonly("trips_per_day_per_ac", &AircraftRoute::TPDPoint::trips_per_day_per_ac)
+        .def_readonly("num_ac", &AircraftRoute::TPDPoint::num_ac)
+        .def_readonly("config", &AircraftRoute::TPDPoint::config)
+        .def_readonly("income", &AircraftRoute::TPDPoint::income)
+        .def_readonly("co2", &AircraftRoute::TPDPoint::co2)
+        .def_readonly("profit", &AircraftRoute::TPDPoint::profit)
+        .def("to_dict", py::overload_cast<const AircraftRoute::TPDPoint&>(&to_dict));
+    py::class_<AircraftRoute::LoadTerms>(acr_class, "LoadTerms")
+        .def_static(
+            "of", &AircraftRoute::LoadTerms::of, "ar"_a, "ac"_a,
+            py::arg_v("user", User::Default(), "am4.utils.game.User.Default()")
+        )
+        .def_readonly("co2_empty", &AircraftRoute::LoadTerms::co2_empty)
+        .def_readonly("co2_full", &AircraftRoute::LoadTerms::co2_full)
+        .def_readonly("fixed_cost", &AircraftRoute::LoadTerms::fixed_cost)
+        .def_readonly("flights_per_day", &AircraftRoute::LoadTerms::flights_per_day)
+        .def("income", &AircraftRoute::LoadTerms::income, "load"_a)
+        .def("profit", &AircraftRoute::LoadTerms::profit, "load"_a);
 
     py::class_<AircraftRoute::Stopover>(acr_class, "Stopover")
         .def_readonly("airport", &AircraftRoute::Stopover::airport)
@@ -712,7 +1903,8 @@ void pybind_init_route(py::module_& m) {
         .value("ERR_NO_STOPOVER", AircraftRoute::Warning::ERR_NO_STOPOVER)
         .value("ERR_FLIGHT_TIME_ABOVE_SPECIFIED", AircraftRoute::Warning::ERR_FLIGHT_TIME_ABOVE_SPECIFIED)
         .value("ERR_INSUFFICIENT_DEMAND", AircraftRoute::Warning::ERR_INSUFFICIENT_DEMAND)
-        .value("ERR_TRIPS_PER_DAY_TOO_HIGH", AircraftRoute::Warning::ERR_TRIPS_PER_DAY_TOO_HIGH);
+        .value("ERR_TRIPS_PER_DAY_TOO_HIGH", AircraftRoute::Warning::ERR_TRIPS_PER_DAY_TOO_HIGH)
+        .value("ERR_DISTANCE_BELOW_SPECIFIED", AircraftRoute::Warning::ERR_DISTANCE_BELOW_SPECIFIED);
 
     acr_class.def_readonly("route", &AircraftRoute::route)
         .def_readonly("config", &AircraftRoute::config)
@@ -734,6 +1926,7 @@ void pybind_init_route(py::module_& m) {
         .def_readonly("warnings", &AircraftRoute::warnings)
         .def_readonly("valid", &AircraftRoute::valid)
         .def_readonly("max_tpd", &AircraftRoute::max_tpd)
+        .def("reprice", &AircraftRoute::reprice, "fuel_price"_a, "co2_price"_a)
         .def_static(
             "create", &AircraftRoute::create, "ap0"_a, "ap1"_a, "ac"_a,
             py::arg_v("options", AircraftRoute::Options(), "AircraftRoute.Options()"),
@@ -743,6 +1936,16 @@ void pybind_init_route(py::module_& m) {
             "estimate_load", &AircraftRoute::estimate_load, "reputation"_a = 87, "autoprice_ratio"_a = 1.06,
             "has_stopover"_a = false
         )
+        .def_static(
+            "tpd_curve", &AircraftRoute::tpd_curve, "ar"_a, "ac"_a,
+            py::arg_v("options", AircraftRoute::Options(), "AircraftRoute.Options()"),
+            py::arg_v("user", User::Default(), "am4.utils.game.User.Default()")
+        )
+        .def_static(
+            "with_num_ac", &AircraftRoute::with_num_ac, "ar"_a, "ac"_a, "num_ac"_a,
+            py::arg_v("options", AircraftRoute::Options(), "AircraftRoute.Options()"),
+            py::arg_v("user", User::Default(), "am4.utils.game.User.Default()")
+        )
         .def_static(
             "calc_fuel", &AircraftRoute::calc_fuel, "ac"_a, "distance"_a,
             py::arg_v("user", User::Default(), "am4.utils.game.User.Default()"), "ci"_a = 200
@@ -771,13 +1974,84 @@ void pybind_init_route(py::module_& m) {
         .def_readonly("ac_route", &Destination::ac_route)
         .def("to_dict", py::overload_cast<const Destination&>(&to_dict));
 
-    py::class_<RoutesSearch>(m_route, "RoutesSearch")
+    py::class_<CancellationToken>(m_route, "CancellationToken")
+        .def(py::init<std::optional<double>>(), "timeout"_a = py::none())
+        .def("cancel", &CancellationToken::cancel)
+        .def_property_readonly("cancelled", &CancellationToken::cancelled);
+
+    py::class_<RoutesSearch> rs_class(m_route, "RoutesSearch");
+    py::class_<RoutesSearch::Filter>(rs_class, "Filter")
         .def(
-            py::init<const Airport&, const Aircraft&, const AircraftRoute::Options&, const User&>(), "ap0"_a, "ac"_a,
-            py::arg_v("options", AircraftRoute::Options(), "AircraftRoute.Options()"),
-            py::arg_v("user", User::Default(), "am4.utils.game.User.Default()")
+            py::init<
+                uint16_t, uint8_t, uint32_t, const vector<string>&, const vector<string>&, const vector<uint16_t>&>(),
+            "min_rwy"_a = 0, "min_market"_a = 0, "max_hub_cost"_a = std::numeric_limits<uint32_t>::max(),
+            "continents"_a = vector<string>(), "countries"_a = vector<string>(), "exclude_ids"_a = vector<uint16_t>()
+        )
+        .def_readwrite("min_rwy", &RoutesSearch::Filter::min_rwy)
+        .def_readwrite("min_market", &RoutesSearch::Filter::min_market)
+        .def_readwrite("max_hub_cost", &RoutesSearch::Filter::max_hub_cost)
+        .def_readwrite("continents", &RoutesSearch::Filter::continents)
+        .def_readwrite("countries", &RoutesSearch::Filter::countries)
+        .def_readwrite("exclude_ids", &RoutesSearch::Filter::exclude_ids)
+        .def_static("parse", &RoutesSearch::Filter::parse, "expr"_a)
+        .def("empty", &RoutesSearch::Filter::empty);
+    py::class_<RoutesSearch::Result>(rs_class, "Result")
+        .def_readonly("destinations", &RoutesSearch::Result::destinations)
+        .def_readonly("truncated", &RoutesSearch::Result::truncated)
+        .def_readonly("evaluated", &RoutesSearch::Result::evaluated);
+    py::class_<RoutesSearch::Stream, shared_ptr<RoutesSearch::Stream>>(rs_class, "Stream")
+        .def_readonly("top_k", &RoutesSearch::Stream::top_k)
+        .def("next_chunk", &RoutesSearch::Stream::next_chunk, py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly("done", &RoutesSearch::Stream::done)
+        .def_property_readonly("evaluated", &RoutesSearch::Stream::evaluated)
+        .def_property_readonly("total", &RoutesSearch::Stream::total)
+        .def("top", &RoutesSearch::Stream::top)
+        .def("__iter__", [](py::object self) { return self; })
+        .def("__next__", [](RoutesSearch::Stream& stream) {
+            if (stream.done()) throw py::stop_iteration();
+            py::gil_scoped_release release;
+            return stream.next_chunk();
+        });
+    rs_class
+        .def(
+            py::init<
+                const Airport&, const Aircraft&, const AircraftRoute::Options&, const User&,
+                const RoutesSearch::Filter&>(),
+            "ap0"_a, "ac"_a, py::arg_v("options", AircraftRoute::Options(), "AircraftRoute.Options()"),
+            py::arg_v("user", User::Default(), "am4.utils.game.User.Default()"),
+            py::arg_v("filter", RoutesSearch::Filter(), "RoutesSearch.Filter()")
         )
         .def("get", &RoutesSearch::get, py::call_guard<py::gil_scoped_release>())
+        .def(
+            "run", &RoutesSearch::run, "token"_a, "on_chunk"_a = py::none(), py::call_guard<py::gil_scoped_release>()
+        )
+        .def("stream", &RoutesSearch::stream, "top_k"_a = 10)
+        .def("top_k", &RoutesSearch::top_k, "k"_a, py::call_guard<py::gil_scoped_release>())
+        .def("reprice", &RoutesSearch::reprice, "destinations"_a, "fuel_price"_a, "co2_price"_a)
+        .def(
+            "pareto", &RoutesSearch::pareto, "objectives"_a,
+            py::arg_v("token", CancellationToken(), "CancellationToken()"), py::call_guard<py::gil_scoped_release>()
+        )
         .def("_get_columns", py::overload_cast<const RoutesSearch&, const vector<Destination>&>(&_get_columns));
+
+    py::class_<AircraftSearch> as_class(m_route, "AircraftSearch");
+    py::class_<AircraftSearch::Candidate>(as_class, "Candidate")
+        .def_readonly("aircraft", &AircraftSearch::Candidate::aircraft)
+        .def_readonly("ac_route", &AircraftSearch::Candidate::ac_route)
+        .def("to_dict", py::overload_cast<const AircraftSearch::Candidate&>(&to_dict));
+    as_class
+        .def(
+            py::init<const Airport&, const Airport&, const AircraftRoute::Options&, const User&, bool, uint16_t>(),
+            "ap0"_a, "ap1"_a, py::arg_v("options", AircraftRoute::Options(), "AircraftRoute.Options()"),
+            py::arg_v("user", User::Default(), "am4.utils.game.User.Default()"), "include_mods"_a = true,
+            "threads"_a = 0
+        )
+        .def_readonly("origin", &AircraftSearch::origin)
+        .def_readonly("destination", &AircraftSearch::destination)
+        .def_readonly("options", &AircraftSearch::options)
+        .def_readonly("user", &AircraftSearch::user)
+        .def_readonly("include_mods", &AircraftSearch::include_mods)
+        .def_readonly("threads", &AircraftSearch::threads)
+        .def("top_k", &AircraftSearch::top_k, "k"_a = 10, py::call_guard<py::gil_scoped_release>());
 }
 #endif
\ No newline at end of file
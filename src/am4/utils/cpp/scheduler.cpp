@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "include/scheduler.hpp"
+#include "include/db.hpp"
+
+using std::chrono::duration;
+
+shared_ptr<Scheduler> Scheduler::Default() {
+    static const shared_ptr<Scheduler> default_scheduler = make_shared<Scheduler>();
+    return default_scheduler;
+}
+
+// 0 means "derive from the number of cores": interactive jobs may use every core, API calls 3/4 and batch jobs half,
+// so a long batch sweep can never starve the other classes.
+Scheduler::Scheduler(uint16_t max_concurrency, std::array<uint16_t, PRIORITY_COUNT> class_limits)
+    : max_concurrency(max_concurrency), class_limits(class_limits), _stats() {
+    if (this->max_concurrency == 0)
+        this->max_concurrency = static_cast<uint16_t>(std::max(1u, std::thread::hardware_concurrency()));
+    const uint16_t defaults[PRIORITY_COUNT] = {
+        this->max_concurrency, static_cast<uint16_t>(std::max(1, this->max_concurrency * 3 / 4)),
+        static_cast<uint16_t>(std::max(1, this->max_concurrency / 2))
+    };
+    for (size_t p = 0; p < PRIORITY_COUNT; p++) {
+        if (this->class_limits[p] == 0) this->class_limits[p] = defaults[p];
+    }
+    _stats.seconds_per_unit = 5e-6;
+}
+
+double Scheduler::estimate_cost(const RoutesSearch& rs) {
+    // fraction of the earth's surface within a spherical cap of radius d, assuming airports are ~uniformly spread
+    auto cap_fraction = [](double d) { return (1. - cos(std::min(d, MAX_DISTANCE) / 6371.)) / 2.; };
+    const double range = static_cast<double>(rs.aircraft.range);
+    const double max_distance = std::min(rs.options.max_distance, 2. * range);
+    const double min_distance = rs.options.min_distance;
+    const double direct =
+        std::max(0., cap_fraction(std::min(max_distance, range)) - cap_fraction(std::min(min_distance, range)));
+    const double stopover = std::max(0., cap_fraction(max_distance) - cap_fraction(std::max(min_distance, range)));
+
+    constexpr double STOPOVER_WEIGHT = 4.;  // a full scan over all airports costs about as much as a few config solves
+    return 1. + static_cast<double>(AIRPORT_COUNT) * (direct + stopover * STOPOVER_WEIGHT);
+}
+
+double Scheduler::estimate_seconds(double cost) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return cost * _stats.seconds_per_unit;
+}
+
+bool Scheduler::can_start(size_t p, uint64_t ticket) const {
+    if (running_total >= max_concurrency || _stats.running[p] >= class_limits[p]) return false;
+    if (queues[p].front() != ticket) return false;
+    // a higher priority job that is able to start takes precedence
+    for (size_t q = 0; q < p; q++) {
+        if (!queues[q].empty() && _stats.running[q] < class_limits[q]) return false;
+    }
+    return true;
+}
+
+double Scheduler::estimate_wait(size_t p) const {
+    double cost_ahead = 0;
+    for (size_t q = 0; q <= p; q++) cost_ahead += _stats.queued_cost[q];
+    const bool slot_free = running_total < max_concurrency && _stats.running[p] < class_limits[p];
+    if (slot_free && cost_ahead == 0) return 0;
+    const uint16_t slots = std::min(max_concurrency, class_limits[p]);
+    return cost_ahead * _stats.seconds_per_unit / static_cast<double>(slots);
+}
+
+void Scheduler::acquire(size_t p, double cost, std::optional<Clock::time_point> deadline) {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (deadline.has_value()) {
+        const double remaining = duration<double>(deadline.value() - Clock::now()).count();
+        const double expected = estimate_wait(p) + cost * _stats.seconds_per_unit;
+        if (expected > remaining) {
+            _stats.rejected[p]++;
+            throw SchedulerRejectedException(
+                "Search rejected: expected to take " + to_string(expected) + "s but only " + to_string(remaining) +
+                "s remain until the deadline."
+            );
+        }
+    }
+
+    const uint64_t ticket = next_ticket++;
+    queues[p].push_back(ticket);
+    _stats.queued[p]++;
+    _stats.queued_cost[p] += cost;
+
+    auto ready = [&] { return can_start(p, ticket); };
+    bool started = true;
+    if (deadline.has_value()) {
+        started = cv.wait_until(lock, deadline.value(), ready);
+    } else {
+        cv.wait(lock, ready);
+    }
+
+    queues[p].erase(std::find(queues[p].begin(), queues[p].end(), ticket));
+    _stats.queued[p]--;
+    _stats.queued_cost[p] -= cost;
+    if (!started) {
+        _stats.rejected[p]++;
+        cv.notify_all();
+        throw SchedulerRejectedException("Search rejected: deadline expired while queued.");
+    }
+    _stats.running[p]++;
+    running_total++;
+    cv.notify_all();
+}
+
+void Scheduler::release(size_t p, double cost, double elapsed) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        _stats.running[p]--;
+        running_total--;
+        _stats.completed[p]++;
+        if (cost > 0 && elapsed > 0) {
+            constexpr double ALPHA = 0.2;  // exponentially weighted so the estimate follows the current load
+            _stats.seconds_per_unit = (1 - ALPHA) * _stats.seconds_per_unit + ALPHA * elapsed / cost;
+        }
+    }
+    cv.notify_all();
+}
+
+RoutesSearch::Result Scheduler::execute(const RoutesSearch& rs, size_t p, const CancellationToken& token) {
+    const double cost = estimate_cost(rs);
+    acquire(p, cost, token.deadline);
+    const auto start = Clock::now();
+    RoutesSearch::Result result;
+    try {
+        result = rs.run(token);
+    } catch (...) {
+        release(p, 0, 0);
+        throw;
+    }
+    // truncated runs would skew the calibration downwards
+    release(p, result.truncated ? 0 : cost, duration<double>(Clock::now() - start).count());
+    return result;
+}
+
+/*
+A request only joins a search of its own or a higher priority class, so it never waits behind a class that would not
+have been scheduled ahead of it. The in-flight map is keyed by (search, class) for that reason.
+*/
+RoutesSearch::Result Scheduler::submit(const RoutesSearch& rs, Priority priority, std::optional<double> timeout) {
+    const size_t p = static_cast<size_t>(priority);
+    const CancellationToken token(timeout);
+    const string key = rs.key();
+    auto inflight_key = [&key](size_t q) { return key + '\0' + static_cast<char>('0' + q); };
+
+    std::promise<RoutesSearch::Result> promise;
+    std::shared_future<RoutesSearch::Result> future;
+    bool leader = true;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (size_t q = 0; q <= p && leader; q++) {
+            auto it = inflight.find(inflight_key(q));
+            if (it == inflight.end()) continue;
+            future = it->second;
+            leader = false;
+            _stats.coalesced[p]++;
+        }
+        if (leader) {
+            future = promise.get_future().share();
+            inflight.emplace(inflight_key(p), future);
+        }
+    }
+
+    if (!leader) {
+        if (token.deadline.has_value() && future.wait_until(token.deadline.value()) != std::future_status::ready) {
+            std::lock_guard<std::mutex> lock(mtx);
+            _stats.rejected[p]++;
+            throw SchedulerRejectedException(
+                "Search rejected: deadline expired while waiting for an identical search."
+            );
+        }
+        // the leader was rejected or ran out of time, but this request may still have some left: start over with it
+        auto retry = [&] {
+            std::optional<double> remaining = std::nullopt;
+            if (token.deadline.has_value()) remaining = duration<double>(token.deadline.value() - Clock::now()).count();
+            return submit(rs, priority, remaining);
+        };
+        RoutesSearch::Result result;
+        try {
+            result = future.get();
+        } catch (const SchedulerRejectedException&) {
+            if (token.cancelled()) throw;
+            return retry();
+        }
+        if (result.truncated && !token.cancelled()) return retry();
+        return result;
+    }
+
+    // the entry is removed before the result is published so that a follower retrying after a truncated or rejected
+    // leader starts a fresh search instead of rejoining this one.
+    auto finish = [&] {
+        std::lock_guard<std::mutex> lock(mtx);
+        inflight.erase(inflight_key(p));
+    };
+    try {
+        RoutesSearch::Result result = execute(rs, p, token);
+        finish();
+        promise.set_value(result);
+        return result;
+    } catch (...) {
+        finish();
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+Scheduler::Stats Scheduler::stats() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return _stats;
+}
+
+inline const string to_string(Scheduler::Priority priority) {
+    switch (priority) {
+        case Scheduler::Priority::INTERACTIVE:
+            return "INTERACTIVE";
+        case Scheduler::Priority::API:
+            return "API";
+        case Scheduler::Priority::BATCH:
+            return "BATCH";
+        default:
+            return "[UNKNOWN]";
+    }
+}
+
+#if BUILD_PYBIND == 1
+#include "include/binder.hpp"
+
+py::dict to_dict(const Scheduler::Stats& s) {
+    py::dict d;
+    for (size_t p = 0; p < Scheduler::PRIORITY_COUNT; p++) {
+        d[py::str(to_string(static_cast<Scheduler::Priority>(p)))] = py::dict(
+            "queued"_a = s.queued[p], "running"_a = s.running[p], "completed"_a = s.completed[p],
+            "rejected"_a = s.rejected[p], "coalesced"_a = s.coalesced[p], "queued_cost"_a = s.queued_cost[p]
+        );
+    }
+    d["seconds_per_unit"] = s.seconds_per_unit;
+    return d;
+}
+
+void pybind_init_scheduler(py::module_& m) {
+    py::module_ m_sched = m.def_submodule("scheduler");
+
+    py::register_exception<SchedulerRejectedException>(m_sched, "SchedulerRejectedException");
+
+    py::class_<Scheduler, shared_ptr<Scheduler>> sched_class(m_sched, "Scheduler");
+    py::enum_<Scheduler::Priority>(sched_class, "Priority")
+        .value("INTERACTIVE", Scheduler::Priority::INTERACTIVE)
+        .value("API", Scheduler::Priority::API)
+        .value("BATCH", Scheduler::Priority::BATCH);
+
+    py::class_<Scheduler::Stats>(sched_class, "Stats")
+        .def_readonly("queued", &Scheduler::Stats::queued)
+        .def_readonly("running", &Scheduler::Stats::running)
+        .def_readonly("completed", &Scheduler::Stats::completed)
+        .def_readonly("rejected", &Scheduler::Stats::rejected)
+        .def_readonly("coalesced", &Scheduler::Stats::coalesced)
+        .def_readonly("queued_cost", &Scheduler::Stats::queued_cost)
+        .def_readonly("seconds_per_unit", &Scheduler::Stats::seconds_per_unit)
+        .def("to_dict", py::overload_cast<const Scheduler::Stats&>(&to_dict));
+
+    sched_class
+        .def(
+            py::init<uint16_t, std::array<uint16_t, Scheduler::PRIORITY_COUNT>>(), "max_concurrency"_a = 0,
+            "class_limits"_a = std::array<uint16_t, Scheduler::PRIORITY_COUNT>{0, 0, 0}
+        )
+        .def_readonly("max_concurrency", &Scheduler::max_concurrency)
+        .def_readonly("class_limits", &Scheduler::class_limits)
+        .def_static("estimate_cost", &Scheduler::estimate_cost, "rs"_a)
+        .def("estimate_seconds", &Scheduler::estimate_seconds, "cost"_a)
+        .def(
+            "submit", &Scheduler::submit, "rs"_a,
+            py::arg_v("priority", Scheduler::Priority::INTERACTIVE, "Scheduler.Priority.INTERACTIVE"),
+            "timeout"_a = py::none(), py::call_guard<py::gil_scoped_release>()
+        )
+        .def("stats", &Scheduler::stats)
+        .def_static("Default", &Scheduler::Default);
+}
+#endif
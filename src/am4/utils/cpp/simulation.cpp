@@ -0,0 +1,393 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "include/simulation.hpp"
+
+// splitmix64's output function applied to a counter: every draw is a pure function of (key, counter), so any range of
+// samples can be simulated on any thread, in any order.
+inline uint64_t counter_hash(uint64_t key, uint64_t counter) {
+    uint64_t z = key + (counter + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// in (0, 1]
+inline double to_unit(uint64_t h) { return static_cast<double>((h >> 11) + 1) * 0x1.0p-53; }
+
+// everything a sample needs about one route, so the inner loop only draws loads
+struct LoadSimulation::Job {
+    uint64_t key;
+    AircraftRoute::LoadTerms terms;
+    double mean_load;
+    double spread;  // standard deviation if `normal`, half range otherwise
+    bool normal;
+};
+
+LoadSimulation::LoadSimulation(
+    uint32_t samples, double autoprice_ratio, std::optional<double> reputation, uint64_t seed, uint16_t threads
+)
+    : samples(samples), autoprice_ratio(autoprice_ratio), reputation(reputation), seed(seed), threads(threads) {
+    if (samples == 0) throw std::invalid_argument("samples must be positive");
+}
+
+double LoadSimulation::mean_load(const AircraftRoute& ar, const User& user) const {
+    if (!this->reputation.has_value()) return user.load;
+    return AircraftRoute::estimate_load(this->reputation.value(), this->autoprice_ratio, ar.stopover.exists);
+}
+
+void LoadSimulation::simulate(const Job& job, uint32_t first, uint32_t last, double* load_sums) const {
+    constexpr double TWO_PI = 2 * M_PI;
+    for (uint32_t s = first; s < last; s++) {
+        double sum = 0;
+        for (uint32_t i = 0; i < job.terms.flights_per_day; i++) {
+            const uint64_t c = 2 * (static_cast<uint64_t>(s) * job.terms.flights_per_day + i);
+            double load;
+            if (job.normal) {  // box-muller
+                const double r = sqrt(-2 * log(to_unit(counter_hash(job.key, c))));
+                load = job.mean_load + job.spread * r * cos(TWO_PI * to_unit(counter_hash(job.key, c + 1)));
+            } else {
+                load = job.mean_load + job.spread * (2 * to_unit(counter_hash(job.key, c)) - 1);
+            }
+            sum += std::clamp(load, 0.0, 1.0);
+        }
+        load_sums[s] = sum;
+    }
+}
+
+// linear interpolation between the closest ranks, `sorted` must be non-empty
+inline double percentile(const vector<double>& sorted, double q) {
+    const double pos = q * static_cast<double>(sorted.size() - 1);
+    const size_t lo = static_cast<size_t>(pos);
+    if (lo + 1 >= sorted.size()) return sorted.back();
+    return sorted[lo] + (sorted[lo + 1] - sorted[lo]) * (pos - static_cast<double>(lo));
+}
+
+inline LoadSimulation::Bands bands(vector<double>& values) {
+    std::sort(values.begin(), values.end());
+    LoadSimulation::Bands b;
+    b.p10 = percentile(values, 0.1);
+    b.p50 = percentile(values, 0.5);
+    b.p90 = percentile(values, 0.9);
+    double total = 0;
+    for (double v : values) total += v;
+    b.mean = total / static_cast<double>(values.size());
+    return b;
+}
+
+// the day's flights share the demand, so only their total load matters
+LoadSimulation::Result LoadSimulation::summarise(const Job& job, vector<double>& load_sums) const {
+    const double n = static_cast<double>(job.terms.flights_per_day);
+    vector<double> loads(load_sums.size()), incomes(load_sums.size()), profits(load_sums.size());
+    for (size_t s = 0; s < load_sums.size(); s++) {
+        loads[s] = load_sums[s] / n;
+        incomes[s] = n * job.terms.income(loads[s]);
+        profits[s] = n * job.terms.profit(loads[s]);
+    }
+    Result r;
+    r.load = bands(loads);
+    r.income = bands(incomes);
+    r.profit = bands(profits);
+    r.flights_per_day = job.terms.flights_per_day;
+    r.mean_load = job.mean_load;
+    return r;
+}
+
+LoadSimulation::Job LoadSimulation::make_job(
+    const AircraftRoute& ar, const Aircraft& ac, const User& user, uint64_t stream
+) const {
+    Job job;
+    job.key = counter_hash(this->seed, stream);
+    job.terms = AircraftRoute::LoadTerms::of(ar, ac, user);
+    job.mean_load = std::clamp(this->mean_load(ar, user), 0.0, 1.0);
+    job.normal = this->autoprice_ratio > 1;
+    job.spread = job.mean_load * (job.normal ? 0.068 : 0.052);
+    return job;
+}
+
+vector<LoadSimulation::Result> LoadSimulation::run_jobs(const vector<Job>& jobs) const {
+    // one task per (route, chunk): a handful of routes still keeps every thread busy
+    const size_t chunks = (this->samples + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    vector<vector<double>> load_sums(jobs.size(), vector<double>(this->samples));
+    parallel_for(jobs.size() * chunks, this->threads, [&](size_t t) {
+        const size_t j = t / chunks;
+        const uint32_t first = static_cast<uint32_t>(t % chunks) * CHUNK_SIZE;
+        this->simulate(jobs[j], first, std::min(first + CHUNK_SIZE, this->samples), load_sums[j].data());
+    });
+
+    vector<Result> results;
+    results.reserve(jobs.size());
+    for (size_t j = 0; j < jobs.size(); j++) results.push_back(this->summarise(jobs[j], load_sums[j]));
+    return results;
+}
+
+LoadSimulation::Result LoadSimulation::run(
+    const AircraftRoute& ar, const Aircraft& ac, const User& user, uint64_t stream
+) const {
+    return this->run_jobs({this->make_job(ar, ac, user, stream)})[0];
+}
+
+vector<LoadSimulation::Result> LoadSimulation::run(
+    const vector<Destination>& destinations, const Aircraft& ac, const User& user
+) const {
+    vector<Job> jobs;
+    jobs.reserve(destinations.size());
+    for (const Destination& d : destinations) jobs.push_back(this->make_job(d.ac_route, ac, user, d.airport.id));
+    return this->run_jobs(jobs);
+}
+
+vector<std::pair<Destination, LoadSimulation::Result>> LoadSimulation::top_k(
+    const RoutesSearch& search, uint16_t k
+) const {
+    const vector<Destination> destinations = search.top_k(k);
+    const vector<Result> results = this->run(destinations, search.aircraft, search.user);
+    vector<std::pair<Destination, Result>> out;
+    out.reserve(destinations.size());
+    for (size_t i = 0; i < destinations.size(); i++) out.emplace_back(destinations[i], results[i]);
+    return out;
+}
+
+inline uint8_t campaign_tier(Campaign::Airline airline) { return static_cast<uint8_t>(airline) / 10; }
+inline uint8_t campaign_level(uint8_t tier, bool eco) { return static_cast<uint8_t>(tier * 2 + eco); }
+
+inline uint16_t planes_flying(const vector<CampaignPlanner::Entry>& routes, const User& user) {
+    uint32_t planes = 0;
+    for (const CampaignPlanner::Entry& e : routes) planes += e.ac_route.num_ac;
+    return static_cast<uint16_t>(std::min<uint32_t>(std::max<uint32_t>(planes, user.accumulated_count), UINT16_MAX));
+}
+
+inline vector<CampaignPlanner::Entry> entries(const vector<Destination>& destinations, const Aircraft& ac) {
+    vector<CampaignPlanner::Entry> e;
+    e.reserve(destinations.size());
+    for (const Destination& d : destinations) e.emplace_back(ac, d.ac_route);
+    return e;
+}
+
+CampaignPlanner::CampaignPlanner(
+    const vector<Entry>& routes, const User& user, double base_reputation, double autoprice_ratio
+)
+    : base_reputation(base_reputation),
+      autoprice_ratio(autoprice_ratio),
+      planes(planes_flying(routes, user)),
+      pax_profit(),
+      cargo_profit(),
+      has_pax(false),
+      has_cargo(false) {
+    std::array<double, LEVELS> loads[2];  // without and with a stopover
+    for (uint8_t tier = 0; tier <= 4; tier++) {
+        for (bool eco : {false, true}) {
+            for (bool stopover : {false, true}) {
+                loads[stopover][campaign_level(tier, eco)] = std::clamp(
+                    AircraftRoute::estimate_load(this->reputation(tier, eco), autoprice_ratio, stopover), 0.0, 1.0
+                );
+            }
+        }
+    }
+    for (const Entry& e : routes) {
+        const AircraftRoute::LoadTerms terms = AircraftRoute::LoadTerms::of(e.ac_route, e.aircraft, user);
+        const bool cargo = e.aircraft.type == Aircraft::Type::CARGO;
+        (cargo ? has_cargo : has_pax) = true;
+        std::array<double, LEVELS>& profit = cargo ? cargo_profit : pax_profit;
+        for (uint8_t l = 0; l < LEVELS; l++) {
+            profit[l] += terms.flights_per_day * terms.profit(loads[e.ac_route.stopover.exists][l]);
+        }
+    }
+}
+
+CampaignPlanner::CampaignPlanner(
+    const vector<Destination>& destinations,
+    const Aircraft& ac,
+    const User& user,
+    double base_reputation,
+    double autoprice_ratio
+)
+    : CampaignPlanner(entries(destinations, ac), user, base_reputation, autoprice_ratio) {}
+
+double CampaignPlanner::reputation(uint8_t tier, bool eco) const {
+    static constexpr Campaign::Airline TIERS[] = {
+        Campaign::Airline::NONE, Campaign::Airline::C1_24HR, Campaign::Airline::C2_24HR, Campaign::Airline::C3_24HR,
+        Campaign::Airline::C4_24HR
+    };
+    return std::min(
+        100.0, this->base_reputation + Campaign::_estimate_airline_reputation(TIERS[tier]) +
+                   Campaign::_estimate_eco_reputation(eco ? Campaign::Eco::C_24HR : Campaign::Eco::NONE)
+    );
+}
+
+vector<Campaign> CampaignPlanner::candidates(uint8_t hours) const {
+    if (hours == 0 || hours > 24 || hours % 4 != 0) throw std::invalid_argument("hours must be one of 4, 8, .., 24");
+    const uint8_t d = hours / 4;
+    auto airline = [d](uint8_t tier) {
+        return tier == 0 ? Campaign::Airline::NONE : static_cast<Campaign::Airline>(tier * 10 + d);
+    };
+    vector<Campaign> c;
+    for (uint8_t pax = 0; pax <= (has_pax ? 4 : 0); pax++) {
+        for (uint8_t cargo = 0; cargo <= (has_cargo ? 4 : 0); cargo++) {
+            for (bool eco : {false, true}) {
+                if (pax == 0 && cargo == 0 && !eco) continue;
+                const Campaign::Eco e = eco ? static_cast<Campaign::Eco>(50 + d) : Campaign::Eco::NONE;
+                c.emplace_back(airline(pax), airline(cargo), e);
+            }
+        }
+    }
+    return c;
+}
+
+/*
+The parts of a campaign may run for different durations: the run is cut wherever one of them ends, and every piece is
+flown at the reputation of the parts still running.
+*/
+CampaignPlanner::Outcome CampaignPlanner::evaluate(const Campaign& campaign) const {
+    const uint8_t pax_tier = campaign_tier(campaign.pax_activated);
+    const uint8_t cargo_tier = campaign_tier(campaign.cargo_activated);
+    const double pax_hours = Campaign::_duration(campaign.pax_activated);
+    const double cargo_hours = Campaign::_duration(campaign.cargo_activated);
+    const double eco_hours = Campaign::_duration(campaign.eco_activated);
+    std::array<double, 3> ends = {pax_hours, cargo_hours, eco_hours};
+    std::sort(ends.begin(), ends.end());
+
+    Outcome o;
+    o.campaign = campaign;
+    o.gain = 0;
+    double start = 0;
+    for (double end : ends) {
+        if (end <= start) continue;
+        const bool eco = eco_hours >= end;
+        const double pax = pax_profit[campaign_level(pax_hours >= end ? pax_tier : 0, eco)] - pax_profit[0];
+        const double cargo = cargo_profit[campaign_level(cargo_hours >= end ? cargo_tier : 0, eco)] - cargo_profit[0];
+        o.gain += (pax + cargo) * (end - start) / 24.0;
+        start = end;
+    }
+    o.cost = campaign.estimate_cost(this->planes);
+    o.net = o.gain - o.cost;
+    o.pax_reputation = this->reputation(pax_tier, campaign.eco_activated != Campaign::Eco::NONE);
+    o.cargo_reputation = this->reputation(cargo_tier, campaign.eco_activated != Campaign::Eco::NONE);
+    return o;
+}
+
+vector<CampaignPlanner::Outcome> CampaignPlanner::rank(const vector<Campaign>& campaigns) const {
+    vector<Outcome> outcomes;
+    outcomes.reserve(campaigns.size());
+    for (const Campaign& c : campaigns) outcomes.push_back(this->evaluate(c));
+    std::stable_sort(outcomes.begin(), outcomes.end(), [](const Outcome& a, const Outcome& b) {
+        return a.net > b.net;
+    });
+    return outcomes;
+}
+
+vector<CampaignPlanner::Outcome> CampaignPlanner::rank(uint8_t hours) const {
+    return this->rank(this->candidates(hours));
+}
+
+double CampaignPlanner::profit_per_day() const { return pax_profit[0] + cargo_profit[0]; }
+
+#if BUILD_PYBIND == 1
+#include "include/binder.hpp"
+
+py::dict to_dict(const LoadSimulation::Bands& b) {
+    return py::dict("p10"_a = b.p10, "p50"_a = b.p50, "p90"_a = b.p90, "mean"_a = b.mean);
+}
+
+py::dict to_dict(const LoadSimulation::Result& r) {
+    return py::dict(
+        "load"_a = to_dict(r.load), "income"_a = to_dict(r.income), "profit"_a = to_dict(r.profit),
+        "flights_per_day"_a = r.flights_per_day, "mean_load"_a = r.mean_load
+    );
+}
+
+py::dict to_dict(const CampaignPlanner::Outcome& o) {
+    return py::dict(
+        "pax_activated"_a = o.campaign.pax_activated, "cargo_activated"_a = o.campaign.cargo_activated,
+        "eco_activated"_a = o.campaign.eco_activated, "gain"_a = o.gain, "cost"_a = o.cost, "net"_a = o.net,
+        "pax_reputation"_a = o.pax_reputation, "cargo_reputation"_a = o.cargo_reputation
+    );
+}
+
+void pybind_init_simulation(py::module_& m) {
+    py::module_ m_sim = m.def_submodule("simulation");
+
+    py::class_<LoadSimulation> ls_class(m_sim, "LoadSimulation");
+    py::class_<LoadSimulation::Bands>(ls_class, "Bands")
+        .def_readonly("p10", &LoadSimulation::Bands::p10)
+        .def_readonly("p50", &LoadSimulation::Bands::p50)
+        .def_readonly("p90", &LoadSimulation::Bands::p90)
+        .def_readonly("mean", &LoadSimulation::Bands::mean)
+        .def("to_dict", py::overload_cast<const LoadSimulation::Bands&>(&to_dict));
+    py::class_<LoadSimulation::Result>(ls_class, "Result")
+        .def_readonly("load", &LoadSimulation::Result::load)
+        .def_readonly("income", &LoadSimulation::Result::income)
+        .def_readonly("profit", &LoadSimulation::Result::profit)
+        .def_readonly("flights_per_day", &LoadSimulation::Result::flights_per_day)
+        .def_readonly("mean_load", &LoadSimulation::Result::mean_load)
+        .def("to_dict", py::overload_cast<const LoadSimulation::Result&>(&to_dict));
+
+    ls_class
+        .def(
+            py::init<uint32_t, double, std::optional<double>, uint64_t, uint16_t>(), "samples"_a = 1000,
+            "autoprice_ratio"_a = 1.06, "reputation"_a = py::none(), "seed"_a = 0, "threads"_a = 0
+        )
+        .def_readonly("samples", &LoadSimulation::samples)
+        .def_readonly("autoprice_ratio", &LoadSimulation::autoprice_ratio)
+        .def_readonly("reputation", &LoadSimulation::reputation)
+        .def_readonly("seed", &LoadSimulation::seed)
+        .def_readonly("threads", &LoadSimulation::threads)
+        .def(
+            "mean_load", &LoadSimulation::mean_load, "ar"_a,
+            py::arg_v("user", User::Default(), "am4.utils.game.User.Default()")
+        )
+        .def(
+            "run",
+            py::overload_cast<const AircraftRoute&, const Aircraft&, const User&, uint64_t>(
+                &LoadSimulation::run, py::const_
+            ),
+            "ar"_a, "ac"_a, py::arg_v("user", User::Default(), "am4.utils.game.User.Default()"), "stream"_a = 0,
+            py::call_guard<py::gil_scoped_release>()
+        )
+        .def(
+            "run",
+            py::overload_cast<const vector<Destination>&, const Aircraft&, const User&>(
+                &LoadSimulation::run, py::const_
+            ),
+            "destinations"_a, "ac"_a, py::arg_v("user", User::Default(), "am4.utils.game.User.Default()"),
+            py::call_guard<py::gil_scoped_release>()
+        )
+        .def("top_k", &LoadSimulation::top_k, "search"_a, "k"_a = 10, py::call_guard<py::gil_scoped_release>());
+
+    py::class_<CampaignPlanner> cp_class(m_sim, "CampaignPlanner");
+    py::class_<CampaignPlanner::Entry>(cp_class, "Entry")
+        .def(py::init<const Aircraft&, const AircraftRoute&>(), "aircraft"_a, "ac_route"_a)
+        .def_readonly("aircraft", &CampaignPlanner::Entry::aircraft)
+        .def_readonly("ac_route", &CampaignPlanner::Entry::ac_route);
+    py::class_<CampaignPlanner::Outcome>(cp_class, "Outcome")
+        .def_readonly("campaign", &CampaignPlanner::Outcome::campaign)
+        .def_readonly("gain", &CampaignPlanner::Outcome::gain)
+        .def_readonly("cost", &CampaignPlanner::Outcome::cost)
+        .def_readonly("net", &CampaignPlanner::Outcome::net)
+        .def_readonly("pax_reputation", &CampaignPlanner::Outcome::pax_reputation)
+        .def_readonly("cargo_reputation", &CampaignPlanner::Outcome::cargo_reputation)
+        .def("to_dict", py::overload_cast<const CampaignPlanner::Outcome&>(&to_dict));
+
+    cp_class
+        .def(
+            py::init<const vector<CampaignPlanner::Entry>&, const User&, double, double>(), "routes"_a,
+            py::arg_v("user", User::Default(), "am4.utils.game.User.Default()"), "base_reputation"_a = 45,
+            "autoprice_ratio"_a = 1.06
+        )
+        .def(
+            py::init<const vector<Destination>&, const Aircraft&, const User&, double, double>(), "destinations"_a,
+            "ac"_a, py::arg_v("user", User::Default(), "am4.utils.game.User.Default()"), "base_reputation"_a = 45,
+            "autoprice_ratio"_a = 1.06
+        )
+        .def_readonly("base_reputation", &CampaignPlanner::base_reputation)
+        .def_readonly("autoprice_ratio", &CampaignPlanner::autoprice_ratio)
+        .def_readonly("planes", &CampaignPlanner::planes)
+        .def("candidates", &CampaignPlanner::candidates, "hours"_a = 24)
+        .def("evaluate", &CampaignPlanner::evaluate, "campaign"_a)
+        .def(
+            "rank", py::overload_cast<const vector<Campaign>&>(&CampaignPlanner::rank, py::const_), "campaigns"_a
+        )
+        .def("rank", py::overload_cast<uint8_t>(&CampaignPlanner::rank, py::const_), "hours"_a = 24)
+        .def("profit_per_day", &CampaignPlanner::profit_per_day);
+}
+#endif
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <numeric>
+
+#include "include/store.hpp"
+#include "include/db.hpp"
+
+shared_ptr<ResultStore> ResultStore::Default() {
+    static const shared_ptr<ResultStore> default_store = make_shared<ResultStore>();
+    return default_store;
+}
+
+ResultStore::ResultStore(size_t capacity) : capacity(std::max(size_t(1), capacity)), rng(std::random_device{}()) {}
+
+string ResultStore::new_cursor() {
+    static const char hex[] = "0123456789abcdef";
+    string cursor;
+    do {
+        uint64_t r = rng();
+        cursor.assign(16, '0');
+        for (size_t i = 0; i < 16; i++, r >>= 4) cursor[i] = hex[r & 0xf];
+    } while (entries.count(cursor) > 0);
+    return cursor;
+}
+
+string ResultStore::put(const RoutesSearch& rs, const RoutesSearch::Result& result) {
+    const auto& db = Database::Client();
+    auto entry = make_shared<Entry>();
+    entry->sort_by = rs.options.sort_by;
+    entry->then_by = rs.options.then_by;
+    entry->fuel_price = rs.user.fuel_price;
+    entry->co2_price = rs.user.co2_price;
+    entry->truncated = result.truncated;
+    entry->airport_idxs.reserve(result.destinations.size());
+    entry->routes.reserve(result.destinations.size());
+    for (const Destination& d : result.destinations) {
+        entry->airport_idxs.push_back(db->airport_id_hashtable[d.airport.id]);
+        entry->routes.push_back(d.ac_route);
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    const string cursor = new_cursor();
+    lru.push_front(cursor);
+    entries.emplace(cursor, std::make_pair(entry, lru.begin()));
+    while (entries.size() > capacity) {
+        entries.erase(lru.back());
+        lru.pop_back();
+    }
+    return cursor;
+}
+
+ResultStore::Page ResultStore::search(
+    const RoutesSearch& rs, uint16_t limit, Scheduler::Priority priority, std::optional<double> timeout
+) {
+    const string cursor = put(rs, Scheduler::Default()->submit(rs, priority, timeout));
+    return page(cursor, 0, limit);
+}
+
+shared_ptr<ResultStore::Entry> ResultStore::get(const string& cursor) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = entries.find(cursor);
+    if (it == entries.end()) throw CursorNotFoundException("Cursor " + cursor + " does not exist or has expired.");
+    lru.splice(lru.begin(), lru, it->second.second);
+    return it->second.first;
+}
+
+ResultStore::Page ResultStore::page(
+    const string& cursor, uint32_t offset, uint16_t limit, std::optional<SortBy> sort_by
+) {
+    const shared_ptr<Entry> entry = get(cursor);
+
+    const uint32_t total = static_cast<uint32_t>(entry->routes.size());
+    const uint32_t start = std::min(offset, total);
+    const uint32_t end = std::min(start + limit, total);
+
+    Page page;
+    page.cursor = cursor;
+    page.offset = start;
+    page.total = total;
+    page.has_more = end < total;
+    page.truncated = entry->truncated;
+    page.destinations.reserve(end - start);
+
+    const auto& db = Database::Client();
+    auto emit = [&](uint32_t row) {
+        page.destinations.emplace_back(db->airports[entry->airport_idxs[row]], entry->routes[row]);
+    };
+    if (!sort_by.has_value() || sort_by.value() == entry->sort_by) {
+        for (uint32_t row = start; row < end; row++) emit(row);
+        return page;
+    }
+
+    std::lock_guard<std::mutex> lock(entry->mtx);
+    auto& order = entry->orders[sort_by.value()];
+    if (order.size() != total) {
+        // ties under the new key fall back to the search's own keys, so the order is the same on every call
+        vector<SortBy> keys = {sort_by.value(), entry->sort_by};
+        keys.insert(keys.end(), entry->then_by.begin(), entry->then_by.end());
+        order = rank_rows(entry->airport_idxs, entry->routes, keys);
+    }
+    for (uint32_t i = start; i < end; i++) emit(order[i]);
+    return page;
+}
+
+/*
+Only the profits move with the prices, so the rows are repriced in a single pass and re-sorted on precomputed values.
+The repriced rows go into a fresh entry that replaces the old one: page() reads the rows without the entry lock, and
+readers that already hold the old entry finish on it. If another reprice replaced the entry in the meantime, start
+over from its rows.
+*/
+void ResultStore::reprice(const string& cursor, std::optional<uint16_t> fuel_price, std::optional<uint8_t> co2_price) {
+    while (true) {
+        const shared_ptr<Entry> old = get(cursor);
+        const uint16_t fp = fuel_price.value_or(old->fuel_price);
+        const uint8_t cp = co2_price.value_or(old->co2_price);
+        if (fp == old->fuel_price && cp == old->co2_price) return;
+
+        auto entry = make_shared<Entry>();
+        entry->sort_by = old->sort_by;
+        entry->then_by = old->then_by;
+        entry->fuel_price = fp;
+        entry->co2_price = cp;
+        entry->truncated = old->truncated;
+        vector<AircraftRoute> routes = old->routes;
+        for (AircraftRoute& ar : routes) ar.reprice(fp, cp);
+
+        vector<SortBy> keys = {old->sort_by};
+        keys.insert(keys.end(), old->then_by.begin(), old->then_by.end());
+        entry->airport_idxs.reserve(routes.size());
+        entry->routes.reserve(routes.size());
+        for (uint32_t row : rank_rows(old->airport_idxs, routes, keys)) {
+            entry->airport_idxs.push_back(old->airport_idxs[row]);
+            entry->routes.push_back(routes[row]);
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = entries.find(cursor);
+        if (it == entries.end()) throw CursorNotFoundException("Cursor " + cursor + " does not exist or has expired.");
+        if (it->second.first != old) continue;
+        it->second.first = entry;
+        return;
+    }
+}
+
+vector<uint32_t> ResultStore::rank_rows(
+    const vector<uint16_t>& airport_idxs, const vector<AircraftRoute>& routes, const vector<SortBy>& keys
+) {
+    const auto& db = Database::Client();
+    const uint32_t total = static_cast<uint32_t>(routes.size());
+    vector<vector<double>> values(keys.size(), vector<double>(total));
+    for (size_t k = 0; k < keys.size(); k++) {
+        for (uint32_t row = 0; row < total; row++) {
+            const uint32_t hub_cost = db->airport_columns.hub_cost[airport_idxs[row]];
+            values[k][row] = RoutesSearch::sort_value(routes[row], keys[k], hub_cost);
+        }
+    }
+    vector<uint32_t> order(total);
+    std::iota(order.begin(), order.end(), uint32_t(0));
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        for (const vector<double>& v : values) {
+            if (v[a] != v[b]) return v[a] > v[b];
+        }
+        return db->airport_columns.id[airport_idxs[a]] < db->airport_columns.id[airport_idxs[b]];
+    });
+    return order;
+}
+
+bool ResultStore::erase(const string& cursor) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = entries.find(cursor);
+    if (it == entries.end()) return false;
+    lru.erase(it->second.second);
+    entries.erase(it);
+    return true;
+}
+
+size_t ResultStore::size() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return entries.size();
+}
+
+#if BUILD_PYBIND == 1
+#include "include/binder.hpp"
+
+py::dict to_dict(const ResultStore::Page& p) {
+    py::list destinations;
+    for (const Destination& d : p.destinations) destinations.append(to_dict(d));
+    return py::dict(
+        "cursor"_a = p.cursor, "offset"_a = p.offset, "total"_a = p.total, "has_more"_a = p.has_more,
+        "truncated"_a = p.truncated, "destinations"_a = destinations
+    );
+}
+
+void pybind_init_store(py::module_& m) {
+    py::module_ m_store = m.def_submodule("store");
+
+    py::register_exception<CursorNotFoundException>(m_store, "CursorNotFoundException");
+
+    py::class_<ResultStore, shared_ptr<ResultStore>> store_class(m_store, "ResultStore");
+    py::class_<ResultStore::Page>(store_class, "Page")
+        .def_readonly("destinations", &ResultStore::Page::destinations)
+        .def_readonly("cursor", &ResultStore::Page::cursor)
+        .def_readonly("offset", &ResultStore::Page::offset)
+        .def_readonly("total", &ResultStore::Page::total)
+        .def_readonly("has_more", &ResultStore::Page::has_more)
+        .def_readonly("truncated", &ResultStore::Page::truncated)
+        .def("to_dict", py::overload_cast<const ResultStore::Page&>(&to_dict));
+
+    store_class.def(py::init<size_t>(), "capacity"_a = 128)
+        .def_readonly("capacity", &ResultStore::capacity)
+        .def("put", &ResultStore::put, "rs"_a, "result"_a)
+        .def(
+            "search", &ResultStore::search, "rs"_a, "limit"_a = 50,
+            py::arg_v("priority", Scheduler::Priority::API, "am4.utils.scheduler.Scheduler.Priority.API"),
+            "timeout"_a = py::none(), py::call_guard<py::gil_scoped_release>()
+        )
+        .def(
+            "page", &ResultStore::page, "cursor"_a, "offset"_a = 0, "limit"_a = 50, "sort_by"_a = py::none(),
+            py::call_guard<py::gil_scoped_release>()
+        )
+        .def(
+            "reprice", &ResultStore::reprice, "cursor"_a, "fuel_price"_a = py::none(), "co2_price"_a = py::none(),
+            py::call_guard<py::gil_scoped_release>()
+        )
+        .def("erase", &ResultStore::erase, "cursor"_a)
+        .def("__len__", &ResultStore::size)
+        .def_static("Default", &ResultStore::Default);
+}
+#endif
@@ -3,9 +3,13 @@ from . import aircraft
 from . import airport
 from . import db
 from . import demand
+from . import fleet
 from . import game
 from . import log
 from . import route
+from . import scheduler
+from . import simulation
+from . import store
 from . import ticket
-__all__ = ['aircraft', 'airport', 'db', 'demand', 'game', 'log', 'route', 'ticket']
+__all__ = ['aircraft', 'airport', 'db', 'demand', 'fleet', 'game', 'log', 'route', 'scheduler', 'simulation', 'store', 'ticket']
 __version__: str = '0.1.8'
@@ -259,6 +259,9 @@ class Aircraft:
     def search(s: str, user: am4.utils.game.User = am4.utils.game.User.Default()) -> Aircraft.SearchResult:
         ...
     @staticmethod
+    def search_many(queries: list[str], user: am4.utils.game.User = am4.utils.game.User.Default()) -> list[Aircraft.SearchResult]:
+        ...
+    @staticmethod
     def suggest(s: Aircraft.ParseResult) -> list[Aircraft.Suggestion]:
         ...
     def __repr__(self) -> str:
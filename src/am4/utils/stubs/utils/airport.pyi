@@ -82,6 +82,9 @@ class Airport:
     def search(s: str) -> Airport.SearchResult:
         ...
     @staticmethod
+    def search_many(queries: list[str]) -> list[Airport.SearchResult]:
+        ...
+    @staticmethod
     def suggest(s: Airport.ParseResult) -> list[Airport.Suggestion]:
         ...
     def __repr__(self) -> str:
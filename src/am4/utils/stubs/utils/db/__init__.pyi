@@ -1,10 +1,89 @@
 from __future__ import annotations
+import am4.utils.airport
+import am4.utils.demand
 import typing
 from . import utils
-__all__ = ['DatabaseException', 'init', 'utils']
+__all__ = ['DatabaseException', 'DemandBlockCache', 'DemandLayer', 'DemandProvider', 'init', 'utils']
 class DatabaseException(Exception):
     pass
+class DemandBlockCache:
+    class Stats:
+        @property
+        def blocks(self) -> int:
+            ...
+        @property
+        def bytes(self) -> int:
+            ...
+        @property
+        def evictions(self) -> int:
+            ...
+        @property
+        def faults(self) -> int:
+            ...
+        @property
+        def hit_rate(self) -> float:
+            ...
+        @property
+        def hits(self) -> int:
+            ...
+    BLOCK_BYTES: typing.ClassVar[int] = 23442
+    def clear(self) -> None:
+        ...
+    def contains(self, ap: am4.utils.airport.Airport) -> bool:
+        ...
+    def reset_stats(self) -> None:
+        ...
+    def stats(self) -> DemandBlockCache.Stats:
+        ...
+    def warm_up(self, hubs: list[am4.utils.airport.Airport]) -> int:
+        ...
+    @property
+    def capacity_bytes(self) -> int:
+        ...
+    @property
+    def max_blocks(self) -> int:
+        ...
+class DemandLayer:
+    def __len__(self) -> int:
+        ...
+    def get(self, route_idx: int, base: am4.utils.demand.PaxDemand) -> am4.utils.demand.PaxDemand:
+        ...
+    @property
+    def key(self) -> str:
+        ...
+    @property
+    def overrides(self) -> dict[int, am4.utils.demand.PaxDemand]:
+        ...
+    @property
+    def version(self) -> int:
+        ...
+class DemandProvider:
+    @staticmethod
+    def Default() -> DemandProvider:
+        ...
+    def __len__(self) -> int:
+        ...
+    def erase(self, key: str) -> bool:
+        ...
+    def get(self, route_idx: int, layer: DemandLayer | None = None) -> am4.utils.demand.PaxDemand:
+        ...
+    def layer(self, key: str) -> DemandLayer | None:
+        ...
+    @typing.overload
+    def set(self, key: str, overrides: list[tuple[int, am4.utils.demand.PaxDemand]]) -> None:
+        ...
+    @typing.overload
+    def set(self, key: str, ap0: am4.utils.airport.Airport, ap1: am4.utils.airport.Airport, demand: am4.utils.demand.PaxDemand) -> None:
+        ...
+    def unset(self, key: str, route_idx: int) -> bool:
+        ...
+    @property
+    def blocks(self) -> DemandBlockCache | None:
+        ...
+    @property
+    def capacity(self) -> int:
+        ...
 def _debug_query(query: str) -> None:
     ...
-def init(home_dir: str | None = None) -> None:
+def init(home_dir: str | None = None, lazy_demand: bool = False, demand_cache_bytes: int = 67108864) -> None:
     ...
@@ -0,0 +1,102 @@
+from __future__ import annotations
+import am4.utils.aircraft
+import am4.utils.airport
+import am4.utils.game
+import am4.utils.route
+import typing
+__all__ = ['FleetAllocator', 'NetworkPlanner']
+class FleetAllocator:
+    class Plan:
+        def to_dict(self) -> dict:
+            ...
+        @property
+        def aircraft_cost(self) -> float:
+            ...
+        @property
+        def destinations(self) -> list[am4.utils.route.Destination]:
+            ...
+        @property
+        def marginal_profits(self) -> list[float]:
+            ...
+        @property
+        def num_ac(self) -> int:
+            ...
+        @property
+        def profit_per_day(self) -> float:
+            ...
+    def __init__(self, search: am4.utils.route.RoutesSearch, fleet_size: int, budget: float | None = None) -> None:
+        ...
+    @typing.overload
+    def allocate(self) -> FleetAllocator.Plan:
+        ...
+    @typing.overload
+    def allocate(self, destinations: list[am4.utils.route.Destination]) -> FleetAllocator.Plan:
+        ...
+    def max_num_ac(self) -> int:
+        ...
+    @property
+    def budget(self) -> float | None:
+        ...
+    @property
+    def fleet_size(self) -> int:
+        ...
+    @property
+    def search(self) -> am4.utils.route.RoutesSearch:
+        ...
+class NetworkPlanner:
+    class Assignment:
+        @property
+        def destination(self) -> am4.utils.route.Destination:
+            ...
+        @property
+        def fleet_idx(self) -> int:
+            ...
+        @property
+        def hub(self) -> am4.utils.airport.Airport:
+            ...
+    class FleetEntry:
+        def __init__(self, aircraft: am4.utils.aircraft.Aircraft, count: int) -> None:
+            ...
+        @property
+        def aircraft(self) -> am4.utils.aircraft.Aircraft:
+            ...
+        @property
+        def count(self) -> int:
+            ...
+    class Plan:
+        def to_dict(self) -> dict:
+            ...
+        @property
+        def assignments(self) -> list[NetworkPlanner.Assignment]:
+            ...
+        @property
+        def marginal_profits(self) -> list[float]:
+            ...
+        @property
+        def num_ac(self) -> list[int]:
+            ...
+        @property
+        def profit_per_day(self) -> float:
+            ...
+        @property
+        def truncated(self) -> bool:
+            ...
+    def __init__(self, hubs: list[am4.utils.airport.Airport], fleet: list[NetworkPlanner.FleetEntry], options: am4.utils.route.AircraftRoute.Options = am4.utils.route.AircraftRoute.Options(), user: am4.utils.game.User = am4.utils.game.User.Default(), threads: int = 0) -> None:
+        ...
+    def plan(self, token: am4.utils.route.CancellationToken = am4.utils.route.CancellationToken()) -> NetworkPlanner.Plan:
+        ...
+    @property
+    def fleet(self) -> list[NetworkPlanner.FleetEntry]:
+        ...
+    @property
+    def hubs(self) -> list[am4.utils.airport.Airport]:
+        ...
+    @property
+    def options(self) -> am4.utils.route.AircraftRoute.Options:
+        ...
+    @property
+    def threads(self) -> int:
+        ...
+    @property
+    def user(self) -> am4.utils.game.User:
+        ...
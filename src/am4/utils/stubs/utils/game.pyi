@@ -166,8 +166,12 @@ class Campaign:
     @staticmethod
     def parse(s: str) -> Campaign:
         ...
+    def __init__(self, pax_activated: Campaign.Airline = Campaign.Airline.NONE, cargo_activated: Campaign.Airline = Campaign.Airline.NONE, eco_activated: Campaign.Eco = Campaign.Eco.NONE) -> None:
+        ...
     def estimate_cargo_reputation(self, base_reputation: float = 45) -> float:
         ...
+    def estimate_cost(self, planes: int) -> float:
+        ...
     def estimate_pax_reputation(self, base_reputation: float = 45) -> float:
         ...
     @property
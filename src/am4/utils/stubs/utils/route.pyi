@@ -1,13 +1,75 @@
 from __future__ import annotations
 import am4.utils.aircraft
 import am4.utils.airport
+import am4.utils.db
 import am4.utils.demand
 import am4.utils.game
+import am4.utils.log
 import am4.utils.ticket
 import typing
-__all__ = ['AircraftRoute', 'Destination', 'Route', 'RoutesSearch', 'SameOdException']
+__all__ = ['AircraftRoute', 'AircraftSearch', 'CancellationToken', 'DemandOverlay', 'Destination', 'InvalidFilterException', 'Route', 'RoutesSearch', 'SameOdException']
 class AircraftRoute:
+    class LoadTerms:
+        @staticmethod
+        def of(ar: AircraftRoute, ac: am4.utils.aircraft.Aircraft, user: am4.utils.game.User = am4.utils.game.User.Default()) -> AircraftRoute.LoadTerms:
+            ...
+        def income(self, load: float) -> float:
+            ...
+        def profit(self, load: float) -> float:
+            ...
+        @property
+        def co2_empty(self) -> float:
+            ...
+        @property
+        def co2_full(self) -> float:
+            ...
+        @property
+        def fixed_cost(self) -> float:
+            ...
+        @property
+        def flights_per_day(self) -> int:
+            ...
     class Options:
+        class CIObjective:
+            """
+            Members:
+            
+              NONE
+            
+              PER_AC_PER_DAY
+            
+              CONTRIBUTION_PER_DAY
+            """
+            CONTRIBUTION_PER_DAY: typing.ClassVar[AircraftRoute.Options.CIObjective]  # value = <CIObjective.CONTRIBUTION_PER_DAY: 2>
+            NONE: typing.ClassVar[AircraftRoute.Options.CIObjective]  # value = <CIObjective.NONE: 0>
+            PER_AC_PER_DAY: typing.ClassVar[AircraftRoute.Options.CIObjective]  # value = <CIObjective.PER_AC_PER_DAY: 1>
+            __members__: typing.ClassVar[dict[str, AircraftRoute.Options.CIObjective]]  # value = {'NONE': <CIObjective.NONE: 0>, 'PER_AC_PER_DAY': <CIObjective.PER_AC_PER_DAY: 1>, 'CONTRIBUTION_PER_DAY': <CIObjective.CONTRIBUTION_PER_DAY: 2>}
+            def __eq__(self, other: typing.Any) -> bool:
+                ...
+            def __getstate__(self) -> int:
+                ...
+            def __hash__(self) -> int:
+                ...
+            def __index__(self) -> int:
+                ...
+            def __init__(self, value: int) -> None:
+                ...
+            def __int__(self) -> int:
+                ...
+            def __ne__(self, other: typing.Any) -> bool:
+                ...
+            def __repr__(self) -> str:
+                ...
+            def __setstate__(self, state: int) -> None:
+                ...
+            def __str__(self) -> str:
+                ...
+            @property
+            def name(self) -> str:
+                ...
+            @property
+            def value(self) -> int:
+                ...
         class SortBy:
             """
             Members:
@@ -15,10 +77,28 @@ class AircraftRoute:
               PER_TRIP
             
               PER_AC_PER_DAY
+            
+              PER_FLIGHT_HOUR
+            
+              CONTRIBUTION_PER_DAY
+            
+              PER_SEAT
+            
+              INCOME
+            
+              PER_DAY_AFTER_HUB_COST
+            
+              FLIGHT_TIME
             """
+            CONTRIBUTION_PER_DAY: typing.ClassVar[AircraftRoute.Options.SortBy]  # value = <SortBy.CONTRIBUTION_PER_DAY: 3>
+            FLIGHT_TIME: typing.ClassVar[AircraftRoute.Options.SortBy]  # value = <SortBy.FLIGHT_TIME: 7>
+            INCOME: typing.ClassVar[AircraftRoute.Options.SortBy]  # value = <SortBy.INCOME: 5>
             PER_AC_PER_DAY: typing.ClassVar[AircraftRoute.Options.SortBy]  # value = <SortBy.PER_AC_PER_DAY: 1>
+            PER_DAY_AFTER_HUB_COST: typing.ClassVar[AircraftRoute.Options.SortBy]  # value = <SortBy.PER_DAY_AFTER_HUB_COST: 6>
+            PER_FLIGHT_HOUR: typing.ClassVar[AircraftRoute.Options.SortBy]  # value = <SortBy.PER_FLIGHT_HOUR: 2>
+            PER_SEAT: typing.ClassVar[AircraftRoute.Options.SortBy]  # value = <SortBy.PER_SEAT: 4>
             PER_TRIP: typing.ClassVar[AircraftRoute.Options.SortBy]  # value = <SortBy.PER_TRIP: 0>
-            __members__: typing.ClassVar[dict[str, AircraftRoute.Options.SortBy]]  # value = {'PER_TRIP': <SortBy.PER_TRIP: 0>, 'PER_AC_PER_DAY': <SortBy.PER_AC_PER_DAY: 1>}
+            __members__: typing.ClassVar[dict[str, AircraftRoute.Options.SortBy]]  # value = {'PER_TRIP': <SortBy.PER_TRIP: 0>, 'PER_AC_PER_DAY': <SortBy.PER_AC_PER_DAY: 1>, 'PER_FLIGHT_HOUR': <SortBy.PER_FLIGHT_HOUR: 2>, 'CONTRIBUTION_PER_DAY': <SortBy.CONTRIBUTION_PER_DAY: 3>, 'PER_SEAT': <SortBy.PER_SEAT: 4>, 'INCOME': <SortBy.INCOME: 5>, 'PER_DAY_AFTER_HUB_COST': <SortBy.PER_DAY_AFTER_HUB_COST: 6>, 'FLIGHT_TIME': <SortBy.FLIGHT_TIME: 7>}
             def __eq__(self, other: typing.Any) -> bool:
                 ...
             def __getstate__(self) -> int:
@@ -85,13 +165,18 @@ class AircraftRoute:
             @property
             def value(self) -> int:
                 ...
+        ci_objective: AircraftRoute.Options.CIObjective
         config_algorithm: None | am4.utils.aircraft.Aircraft.PaxConfig.Algorithm | am4.utils.aircraft.Aircraft.CargoConfig.Algorithm
+        demand_layer: am4.utils.db.DemandLayer | None
+        demand_overlay: DemandOverlay
         max_distance: float
         max_flight_time: float
+        min_distance: float
         sort_by: AircraftRoute.Options.SortBy
+        then_by: list[AircraftRoute.Options.SortBy]
         tpd_mode: AircraftRoute.Options.TPDMode
         trips_per_day_per_ac: int
-        def __init__(self, tpd_mode: AircraftRoute.Options.TPDMode = TPDMode.AUTO, trips_per_day_per_ac: int = 1, max_distance: float = 20015.086796020572, max_flight_time: float = 24.0, config_algorithm: None | am4.utils.aircraft.Aircraft.PaxConfig.Algorithm | am4.utils.aircraft.Aircraft.CargoConfig.Algorithm = None, sort_by: AircraftRoute.Options.SortBy = SortBy.PER_TRIP) -> None:
+        def __init__(self, tpd_mode: AircraftRoute.Options.TPDMode = TPDMode.AUTO, trips_per_day_per_ac: int = 1, max_distance: float = 20015.086796020572, max_flight_time: float = 24.0, config_algorithm: None | am4.utils.aircraft.Aircraft.PaxConfig.Algorithm | am4.utils.aircraft.Aircraft.CargoConfig.Algorithm = None, sort_by: AircraftRoute.Options.SortBy = SortBy.PER_TRIP, min_distance: float = 0.0, then_by: list[AircraftRoute.Options.SortBy] = [], ci_objective: AircraftRoute.Options.CIObjective = CIObjective.NONE, demand_overlay: DemandOverlay = DemandOverlay()) -> None:
             ...
     class Stopover:
         @staticmethod
@@ -110,6 +195,27 @@ class AircraftRoute:
         @property
         def full_distance(self) -> float:
             ...
+    class TPDPoint:
+        def to_dict(self) -> dict:
+            ...
+        @property
+        def co2(self) -> float:
+            ...
+        @property
+        def config(self) -> am4.utils.aircraft.Aircraft.PaxConfig | am4.utils.aircraft.Aircraft.CargoConfig:
+            ...
+        @property
+        def income(self) -> float:
+            ...
+        @property
+        def num_ac(self) -> int:
+            ...
+        @property
+        def profit(self) -> float:
+            ...
+        @property
+        def trips_per_day_per_ac(self) -> int:
+            ...
     class Warning:
         """
         Members:
@@ -131,8 +237,11 @@ class AircraftRoute:
           ERR_INSUFFICIENT_DEMAND
         
           ERR_TRIPS_PER_DAY_TOO_HIGH
+        
+          ERR_DISTANCE_BELOW_SPECIFIED
         """
         ERR_DISTANCE_ABOVE_SPECIFIED: typing.ClassVar[AircraftRoute.Warning]  # value = <Warning.ERR_DISTANCE_ABOVE_SPECIFIED: 1>
+        ERR_DISTANCE_BELOW_SPECIFIED: typing.ClassVar[AircraftRoute.Warning]  # value = <Warning.ERR_DISTANCE_BELOW_SPECIFIED: 9>
         ERR_DISTANCE_TOO_LONG: typing.ClassVar[AircraftRoute.Warning]  # value = <Warning.ERR_DISTANCE_TOO_LONG: 2>
         ERR_DISTANCE_TOO_SHORT: typing.ClassVar[AircraftRoute.Warning]  # value = <Warning.ERR_DISTANCE_TOO_SHORT: 3>
         ERR_FLIGHT_TIME_ABOVE_SPECIFIED: typing.ClassVar[AircraftRoute.Warning]  # value = <Warning.ERR_FLIGHT_TIME_ABOVE_SPECIFIED: 6>
@@ -141,7 +250,7 @@ class AircraftRoute:
         ERR_RWY_TOO_SHORT: typing.ClassVar[AircraftRoute.Warning]  # value = <Warning.ERR_RWY_TOO_SHORT: 0>
         ERR_TRIPS_PER_DAY_TOO_HIGH: typing.ClassVar[AircraftRoute.Warning]  # value = <Warning.ERR_TRIPS_PER_DAY_TOO_HIGH: 8>
         REDUCED_CONTRIBUTION: typing.ClassVar[AircraftRoute.Warning]  # value = <Warning.REDUCED_CONTRIBUTION: 4>
-        __members__: typing.ClassVar[dict[str, AircraftRoute.Warning]]  # value = {'ERR_RWY_TOO_SHORT': <Warning.ERR_RWY_TOO_SHORT: 0>, 'ERR_DISTANCE_ABOVE_SPECIFIED': <Warning.ERR_DISTANCE_ABOVE_SPECIFIED: 1>, 'ERR_DISTANCE_TOO_LONG': <Warning.ERR_DISTANCE_TOO_LONG: 2>, 'ERR_DISTANCE_TOO_SHORT': <Warning.ERR_DISTANCE_TOO_SHORT: 3>, 'REDUCED_CONTRIBUTION': <Warning.REDUCED_CONTRIBUTION: 4>, 'ERR_NO_STOPOVER': <Warning.ERR_NO_STOPOVER: 5>, 'ERR_FLIGHT_TIME_ABOVE_SPECIFIED': <Warning.ERR_FLIGHT_TIME_ABOVE_SPECIFIED: 6>, 'ERR_INSUFFICIENT_DEMAND': <Warning.ERR_INSUFFICIENT_DEMAND: 7>, 'ERR_TRIPS_PER_DAY_TOO_HIGH': <Warning.ERR_TRIPS_PER_DAY_TOO_HIGH: 8>}
+        __members__: typing.ClassVar[dict[str, AircraftRoute.Warning]]  # value = {'ERR_RWY_TOO_SHORT': <Warning.ERR_RWY_TOO_SHORT: 0>, 'ERR_DISTANCE_ABOVE_SPECIFIED': <Warning.ERR_DISTANCE_ABOVE_SPECIFIED: 1>, 'ERR_DISTANCE_TOO_LONG': <Warning.ERR_DISTANCE_TOO_LONG: 2>, 'ERR_DISTANCE_TOO_SHORT': <Warning.ERR_DISTANCE_TOO_SHORT: 3>, 'REDUCED_CONTRIBUTION': <Warning.REDUCED_CONTRIBUTION: 4>, 'ERR_NO_STOPOVER': <Warning.ERR_NO_STOPOVER: 5>, 'ERR_FLIGHT_TIME_ABOVE_SPECIFIED': <Warning.ERR_FLIGHT_TIME_ABOVE_SPECIFIED: 6>, 'ERR_INSUFFICIENT_DEMAND': <Warning.ERR_INSUFFICIENT_DEMAND: 7>, 'ERR_TRIPS_PER_DAY_TOO_HIGH': <Warning.ERR_TRIPS_PER_DAY_TOO_HIGH: 8>, 'ERR_DISTANCE_BELOW_SPECIFIED': <Warning.ERR_DISTANCE_BELOW_SPECIFIED: 9>}
         def __eq__(self, other: typing.Any) -> bool:
             ...
         def __getstate__(self) -> int:
@@ -185,8 +294,16 @@ class AircraftRoute:
     @staticmethod
     def estimate_load(reputation: float = 87, autoprice_ratio: float = 1.06, has_stopover: bool = False) -> float:
         ...
+    @staticmethod
+    def tpd_curve(ar: AircraftRoute, ac: am4.utils.aircraft.Aircraft, options: AircraftRoute.Options = AircraftRoute.Options(), user: am4.utils.game.User = am4.utils.game.User.Default()) -> list[AircraftRoute.TPDPoint]:
+        ...
+    @staticmethod
+    def with_num_ac(ar: AircraftRoute, ac: am4.utils.aircraft.Aircraft, num_ac: int, options: AircraftRoute.Options = AircraftRoute.Options(), user: am4.utils.game.User = am4.utils.game.User.Default()) -> AircraftRoute.TPDPoint | None:
+        ...
     def __repr__(self) -> str:
         ...
+    def reprice(self, fuel_price: int, co2_price: int) -> None:
+        ...
     def to_dict(self) -> dict:
         ...
     @property
@@ -249,6 +366,65 @@ class AircraftRoute:
     @property
     def warnings(self) -> list[AircraftRoute.Warning]:
         ...
+class AircraftSearch:
+    class Candidate:
+        def to_dict(self) -> dict:
+            ...
+        @property
+        def ac_route(self) -> AircraftRoute:
+            ...
+        @property
+        def aircraft(self) -> am4.utils.aircraft.Aircraft:
+            ...
+    def __init__(self, ap0: am4.utils.airport.Airport, ap1: am4.utils.airport.Airport, options: AircraftRoute.Options = AircraftRoute.Options(), user: am4.utils.game.User = am4.utils.game.User.Default(), include_mods: bool = True, threads: int = 0) -> None:
+        ...
+    def top_k(self, k: int = 10) -> list[AircraftSearch.Candidate]:
+        ...
+    @property
+    def destination(self) -> am4.utils.airport.Airport:
+        ...
+    @property
+    def include_mods(self) -> bool:
+        ...
+    @property
+    def options(self) -> AircraftRoute.Options:
+        ...
+    @property
+    def origin(self) -> am4.utils.airport.Airport:
+        ...
+    @property
+    def threads(self) -> int:
+        ...
+    @property
+    def user(self) -> am4.utils.game.User:
+        ...
+class CancellationToken:
+    def __init__(self, timeout: float | None = None) -> None:
+        ...
+    def cancel(self) -> None:
+        ...
+    @property
+    def cancelled(self) -> bool:
+        ...
+class DemandOverlay:
+    def __init__(self) -> None:
+        ...
+    def __len__(self) -> int:
+        ...
+    @typing.overload
+    def consume(self, route_idx: int, demand: am4.utils.demand.PaxDemand) -> None:
+        ...
+    @typing.overload
+    def consume(self, ap0: am4.utils.airport.Airport, ap1: am4.utils.airport.Airport, demand: am4.utils.demand.PaxDemand) -> None:
+        ...
+    def consume_route_list(self, routes: list[am4.utils.log.UserLog.RouteDetail], per_route: am4.utils.demand.PaxDemand) -> int:
+        ...
+    def consumed(self, route_idx: int) -> am4.utils.demand.PaxDemand:
+        ...
+    def entries(self) -> list[tuple[int, am4.utils.demand.PaxDemand]]:
+        ...
+    def remaining(self, route_idx: int, full: am4.utils.demand.PaxDemand) -> am4.utils.demand.PaxDemand:
+        ...
 class Destination:
     def to_dict(self) -> dict:
         ...
@@ -258,6 +434,8 @@ class Destination:
     @property
     def airport(self) -> am4.utils.airport.Airport:
         ...
+class InvalidFilterException(Exception):
+    pass
 class Route:
     @staticmethod
     @typing.overload
@@ -284,11 +462,68 @@ class Route:
     def valid(self) -> bool:
         ...
 class RoutesSearch:
-    def __init__(self, ap0: am4.utils.airport.Airport, ac: am4.utils.aircraft.Aircraft, options: AircraftRoute.Options = AircraftRoute.Options(), user: am4.utils.game.User = am4.utils.game.User.Default()) -> None:
+    class Filter:
+        continents: list[str]
+        countries: list[str]
+        exclude_ids: list[int]
+        max_hub_cost: int
+        min_market: int
+        min_rwy: int
+        @staticmethod
+        def parse(expr: str) -> RoutesSearch.Filter:
+            ...
+        def __init__(self, min_rwy: int = 0, min_market: int = 0, max_hub_cost: int = 4294967295, continents: list[str] = [], countries: list[str] = [], exclude_ids: list[int] = []) -> None:
+            ...
+        def empty(self) -> bool:
+            ...
+    class Result:
+        @property
+        def destinations(self) -> list[Destination]:
+            ...
+        @property
+        def evaluated(self) -> int:
+            ...
+        @property
+        def truncated(self) -> bool:
+            ...
+    class Stream:
+        def __iter__(self) -> RoutesSearch.Stream:
+            ...
+        def __next__(self) -> list[Destination]:
+            ...
+        def next_chunk(self) -> list[Destination]:
+            ...
+        def top(self) -> list[Destination]:
+            ...
+        @property
+        def done(self) -> bool:
+            ...
+        @property
+        def evaluated(self) -> int:
+            ...
+        @property
+        def top_k(self) -> int:
+            ...
+        @property
+        def total(self) -> int:
+            ...
+    def __init__(self, ap0: am4.utils.airport.Airport, ac: am4.utils.aircraft.Aircraft, options: AircraftRoute.Options = AircraftRoute.Options(), user: am4.utils.game.User = am4.utils.game.User.Default(), filter: RoutesSearch.Filter = RoutesSearch.Filter()) -> None:
         ...
     def _get_columns(self, arg0: list[Destination]) -> dict[str, list]:
         ...
+    def candidates(self) -> list[int]:
+        ...
     def get(self) -> list[Destination]:
         ...
+    def pareto(self, objectives: list[AircraftRoute.Options.SortBy], token: CancellationToken = CancellationToken()) -> RoutesSearch.Result:
+        ...
+    def reprice(self, destinations: list[Destination], fuel_price: int, co2_price: int) -> list[Destination]:
+        ...
+    def run(self, token: CancellationToken, on_chunk: typing.Callable[[list[Destination]], None] | None = None) -> RoutesSearch.Result:
+        ...
+    def stream(self, top_k: int = 10) -> RoutesSearch.Stream:
+        ...
+    def top_k(self, k: int) -> list[Destination]:
+        ...
 class SameOdException(Exception):
     pass
@@ -0,0 +1,91 @@
+from __future__ import annotations
+import am4.utils.route
+import typing
+__all__ = ['Scheduler', 'SchedulerRejectedException']
+class Scheduler:
+    class Priority:
+        """
+        Members:
+        
+          INTERACTIVE
+        
+          API
+        
+          BATCH
+        """
+        API: typing.ClassVar[Scheduler.Priority]  # value = <Priority.API: 1>
+        BATCH: typing.ClassVar[Scheduler.Priority]  # value = <Priority.BATCH: 2>
+        INTERACTIVE: typing.ClassVar[Scheduler.Priority]  # value = <Priority.INTERACTIVE: 0>
+        __members__: typing.ClassVar[dict[str, Scheduler.Priority]]  # value = {'INTERACTIVE': <Priority.INTERACTIVE: 0>, 'API': <Priority.API: 1>, 'BATCH': <Priority.BATCH: 2>}
+        def __eq__(self, other: typing.Any) -> bool:
+            ...
+        def __getstate__(self) -> int:
+            ...
+        def __hash__(self) -> int:
+            ...
+        def __index__(self) -> int:
+            ...
+        def __init__(self, value: int) -> None:
+            ...
+        def __int__(self) -> int:
+            ...
+        def __ne__(self, other: typing.Any) -> bool:
+            ...
+        def __repr__(self) -> str:
+            ...
+        def __setstate__(self, state: int) -> None:
+            ...
+        def __str__(self) -> str:
+            ...
+        @property
+        def name(self) -> str:
+            ...
+        @property
+        def value(self) -> int:
+            ...
+    class Stats:
+        def to_dict(self) -> dict:
+            ...
+        @property
+        def coalesced(self) -> list[int]:
+            ...
+        @property
+        def completed(self) -> list[int]:
+            ...
+        @property
+        def queued(self) -> list[int]:
+            ...
+        @property
+        def queued_cost(self) -> list[float]:
+            ...
+        @property
+        def rejected(self) -> list[int]:
+            ...
+        @property
+        def running(self) -> list[int]:
+            ...
+        @property
+        def seconds_per_unit(self) -> float:
+            ...
+    @staticmethod
+    def Default() -> Scheduler:
+        ...
+    @staticmethod
+    def estimate_cost(rs: am4.utils.route.RoutesSearch) -> float:
+        ...
+    def __init__(self, max_concurrency: int = 0, class_limits: list[int] = [0, 0, 0]) -> None:
+        ...
+    def estimate_seconds(self, cost: float) -> float:
+        ...
+    def stats(self) -> Scheduler.Stats:
+        ...
+    def submit(self, rs: am4.utils.route.RoutesSearch, priority: Scheduler.Priority = Scheduler.Priority.INTERACTIVE, timeout: float | None = None) -> am4.utils.route.RoutesSearch.Result:
+        ...
+    @property
+    def class_limits(self) -> list[int]:
+        ...
+    @property
+    def max_concurrency(self) -> int:
+        ...
+class SchedulerRejectedException(Exception):
+    pass
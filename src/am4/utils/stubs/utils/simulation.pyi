@@ -0,0 +1,125 @@
+from __future__ import annotations
+import am4.utils.aircraft
+import am4.utils.game
+import am4.utils.route
+import typing
+__all__ = ['CampaignPlanner', 'LoadSimulation']
+class CampaignPlanner:
+    class Entry:
+        def __init__(self, aircraft: am4.utils.aircraft.Aircraft, ac_route: am4.utils.route.AircraftRoute) -> None:
+            ...
+        @property
+        def ac_route(self) -> am4.utils.route.AircraftRoute:
+            ...
+        @property
+        def aircraft(self) -> am4.utils.aircraft.Aircraft:
+            ...
+    class Outcome:
+        def to_dict(self) -> dict:
+            ...
+        @property
+        def campaign(self) -> am4.utils.game.Campaign:
+            ...
+        @property
+        def cargo_reputation(self) -> float:
+            ...
+        @property
+        def cost(self) -> float:
+            ...
+        @property
+        def gain(self) -> float:
+            ...
+        @property
+        def net(self) -> float:
+            ...
+        @property
+        def pax_reputation(self) -> float:
+            ...
+    @typing.overload
+    def __init__(self, routes: list[CampaignPlanner.Entry], user: am4.utils.game.User = am4.utils.game.User.Default(), base_reputation: float = 45, autoprice_ratio: float = 1.06) -> None:
+        ...
+    @typing.overload
+    def __init__(self, destinations: list[am4.utils.route.Destination], ac: am4.utils.aircraft.Aircraft, user: am4.utils.game.User = am4.utils.game.User.Default(), base_reputation: float = 45, autoprice_ratio: float = 1.06) -> None:
+        ...
+    def candidates(self, hours: int = 24) -> list[am4.utils.game.Campaign]:
+        ...
+    def evaluate(self, campaign: am4.utils.game.Campaign) -> CampaignPlanner.Outcome:
+        ...
+    def profit_per_day(self) -> float:
+        ...
+    @typing.overload
+    def rank(self, campaigns: list[am4.utils.game.Campaign]) -> list[CampaignPlanner.Outcome]:
+        ...
+    @typing.overload
+    def rank(self, hours: int = 24) -> list[CampaignPlanner.Outcome]:
+        ...
+    @property
+    def autoprice_ratio(self) -> float:
+        ...
+    @property
+    def base_reputation(self) -> float:
+        ...
+    @property
+    def planes(self) -> int:
+        ...
+class LoadSimulation:
+    class Bands:
+        def to_dict(self) -> dict:
+            ...
+        @property
+        def mean(self) -> float:
+            ...
+        @property
+        def p10(self) -> float:
+            ...
+        @property
+        def p50(self) -> float:
+            ...
+        @property
+        def p90(self) -> float:
+            ...
+    class Result:
+        def to_dict(self) -> dict:
+            ...
+        @property
+        def flights_per_day(self) -> int:
+            ...
+        @property
+        def income(self) -> LoadSimulation.Bands:
+            ...
+        @property
+        def load(self) -> LoadSimulation.Bands:
+            ...
+        @property
+        def mean_load(self) -> float:
+            ...
+        @property
+        def profit(self) -> LoadSimulation.Bands:
+            ...
+    def __init__(self, samples: int = 1000, autoprice_ratio: float = 1.06, reputation: float | None = None, seed: int = 0, threads: int = 0) -> None:
+        ...
+    def mean_load(self, ar: am4.utils.route.AircraftRoute, user: am4.utils.game.User = am4.utils.game.User.Default()) -> float:
+        ...
+    @typing.overload
+    def run(self, ar: am4.utils.route.AircraftRoute, ac: am4.utils.aircraft.Aircraft, user: am4.utils.game.User = am4.utils.game.User.Default(), stream: int = 0) -> LoadSimulation.Result:
+        ...
+    @typing.overload
+    def run(self, destinations: list[am4.utils.route.Destination], ac: am4.utils.aircraft.Aircraft, user: am4.utils.game.User = am4.utils.game.User.Default()) -> list[LoadSimulation.Result]:
+        ...
+    def top_k(self, search: am4.utils.route.RoutesSearch, k: int = 10) -> list[tuple[am4.utils.route.Destination, LoadSimulation.Result]]:
+        ...
+    @property
+    def autoprice_ratio(self) -> float:
+        ...
+    @property
+    def reputation(self) -> float | None:
+        ...
+    @property
+    def samples(self) -> int:
+        ...
+    @property
+    def seed(self) -> int:
+        ...
+    @property
+    def threads(self) -> int:
+        ...
@@ -0,0 +1,49 @@
+from __future__ import annotations
+import am4.utils.route
+import am4.utils.scheduler
+import typing
+__all__ = ['CursorNotFoundException', 'ResultStore']
+class CursorNotFoundException(Exception):
+    pass
+class ResultStore:
+    class Page:
+        def to_dict(self) -> dict:
+            ...
+        @property
+        def cursor(self) -> str:
+            ...
+        @property
+        def destinations(self) -> list[am4.utils.route.Destination]:
+            ...
+        @property
+        def has_more(self) -> bool:
+            ...
+        @property
+        def offset(self) -> int:
+            ...
+        @property
+        def total(self) -> int:
+            ...
+        @property
+        def truncated(self) -> bool:
+            ...
+    @staticmethod
+    def Default() -> ResultStore:
+        ...
+    def __init__(self, capacity: int = 128) -> None:
+        ...
+    def __len__(self) -> int:
+        ...
+    def erase(self, cursor: str) -> bool:
+        ...
+    def page(self, cursor: str, offset: int = 0, limit: int = 50, sort_by: am4.utils.route.AircraftRoute.Options.SortBy | None = None) -> ResultStore.Page:
+        ...
+    def put(self, rs: am4.utils.route.RoutesSearch, result: am4.utils.route.RoutesSearch.Result) -> str:
+        ...
+    def reprice(self, cursor: str, fuel_price: int | None = None, co2_price: int | None = None) -> None:
+        ...
+    def search(self, rs: am4.utils.route.RoutesSearch, limit: int = 50, priority: am4.utils.scheduler.Scheduler.Priority = am4.utils.scheduler.Scheduler.Priority.API, timeout: float | None = None) -> ResultStore.Page:
+        ...
+    @property
+    def capacity(self) -> int:
+        ...
@@ -79,3 +79,23 @@ def test_aircraft_fourx():
     user.fourx = True
     a1 = Aircraft.search("b744", user=user).ac
     assert a1.speed / a0.speed == pytest.approx(4.0)
+
+
+@pytest.mark.parametrize("mods,ratio", [("s", 1.07), ("f", 1.10), ("c", 1.05), ("sfc", 1.07 * 1.10 * 1.05)])
+def test_aircraft_modifier_cost(mods: str, ratio: float):
+    a0 = Aircraft.search("b744").ac
+    a1 = Aircraft.search(f"b744[{mods}]").ac
+    assert a1.cost / a0.cost == pytest.approx(ratio, rel=1e-6)
+    assert a1.range == a0.range
+
+
+def test_aircraft_search_many():
+    queries = ["b744", "b744[1,sfc]", "B744", "name:b747-400", "b7440", "b744"]
+    results = Aircraft.search_many(queries)
+    assert [r.ac.valid for r in results] == [True, True, True, True, False, True]
+    for q, r in zip(queries, results):
+        expected = Aircraft.search(q)
+        assert r.ac.id == expected.ac.id
+        assert r.ac.eid == expected.ac.eid
+        assert r.ac.speed == pytest.approx(expected.ac.speed)
+        assert r.parse_result.priority == expected.parse_result.priority
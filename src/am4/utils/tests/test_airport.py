@@ -41,3 +41,20 @@ def test_airport_fail_and_suggest(inp):
 def test_airport_stoi_overflow(inp):
     a0 = Airport.search(inp)
     assert not a0.ap.valid
+
+
+@pytest.mark.parametrize("inp", ["+3500", " 3500", "id:-3500", "id:3500 "])
+def test_airport_id_strict(inp):
+    a0 = Airport.search(inp)
+    assert not a0.ap.valid
+
+
+def test_airport_search_many():
+    queries = ["HKG", "iata:lhr", "HKG", "nonexistent", "id:3500"]
+    results = Airport.search_many(queries)
+    assert [r.ap.valid for r in results] == [True, True, True, False, True]
+    for q, r in zip(queries, results):
+        expected = Airport.search(q)
+        assert r.ap.id == expected.ap.id
+        assert r.parse_result.search_type == expected.parse_result.search_type
+        assert r.parse_result.search_str == expected.parse_result.search_str
@@ -0,0 +1,56 @@
+import pytest
+
+from am4.utils.aircraft import Aircraft
+from am4.utils.airport import Airport
+from am4.utils.fleet import FleetAllocator, NetworkPlanner
+from am4.utils.route import AircraftRoute, RoutesSearch
+
+
+def test_allocate_fleet():
+    ap0 = Airport.search("VHHH").ap
+    ac = Aircraft.search("b744").ac
+    rs = RoutesSearch(ap0, ac)
+    destinations = rs.get()
+    plan = FleetAllocator(rs, 30).allocate(destinations)
+
+    assert plan.num_ac == 30
+    assert sum(d.ac_route.num_ac for d in plan.destinations) == 30
+    assert len(plan.marginal_profits) == 30
+    assert plan.profit_per_day == sum(plan.marginal_profits)
+    assert plan.aircraft_cost == 30 * ac.cost
+    per_day = [d.ac_route.profit * d.ac_route.trips_per_day_per_ac * d.ac_route.num_ac for d in plan.destinations]
+    assert sum(per_day) == pytest.approx(plan.profit_per_day)
+    assert per_day == sorted(per_day, reverse=True)
+
+    for d in plan.destinations:
+        point = AircraftRoute.with_num_ac(d.ac_route, ac, d.ac_route.num_ac)
+        assert point is not None
+        assert point.profit == d.ac_route.profit
+
+
+def test_allocate_fleet_budget():
+    ap0 = Airport.search("VHHH").ap
+    ac = Aircraft.search("b744").ac
+    allocator = FleetAllocator(RoutesSearch(ap0, ac), 100, budget=ac.cost * 5.5)
+    assert allocator.max_num_ac() == 5
+    assert allocator.allocate().num_ac == 5
+
+
+def test_network_plan():
+    hubs = [Airport.search(q).ap for q in ("VHHH", "RJTT", "WSSS")]
+    b744 = Aircraft.search("b744").ac
+    fleet = [NetworkPlanner.FleetEntry(b744, 20), NetworkPlanner.FleetEntry(Aircraft.search("a388").ac, 10)]
+    plan = NetworkPlanner(hubs, fleet, threads=2).plan()
+
+    assert plan.truncated is False
+    assert plan.num_ac == [20, 10]
+    assert sum(a.destination.ac_route.num_ac for a in plan.assignments) == 30
+    assert plan.profit_per_day == sum(plan.marginal_profits)
+    for a in plan.assignments:
+        assert a.hub.id in {h.id for h in hubs}
+        assert a.destination.airport.id != a.hub.id
+
+    # with a single hub and aircraft, nothing shares demand and the plan matches the single-hub allocator
+    single = NetworkPlanner([hubs[0]], [NetworkPlanner.FleetEntry(b744, 20)]).plan()
+    allocated = FleetAllocator(RoutesSearch(hubs[0], b744), 20).allocate()
+    assert single.profit_per_day == pytest.approx(allocated.profit_per_day)
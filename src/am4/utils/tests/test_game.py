@@ -32,6 +32,13 @@ def test_campaign_reputation():
     assert rep == 45 + 10
 
 
+def test_campaign_cost():
+    assert Campaign(Campaign.Airline.C1_4HR).estimate_cost(10) == (2625 * 4 + 4500) * 10
+    assert Campaign(eco_activated=Campaign.Eco.C_24HR).estimate_cost(10) == 8270 * 10
+    assert Campaign().estimate_cost(10) == 0
+    assert Campaign.Default().estimate_cost(10) > Campaign.parse("c4").estimate_cost(10)
+
+
 def test_default_user():
     u = User.Default()
     ur = User.Default(True)
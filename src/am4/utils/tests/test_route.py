@@ -2,9 +2,19 @@ import pytest
 
 from am4.utils.aircraft import Aircraft
 from am4.utils.airport import Airport
-from am4.utils.demand import CargoDemand
+from am4.utils.db import DemandBlockCache, DemandProvider, init
+from am4.utils.demand import CargoDemand, PaxDemand
 from am4.utils.game import User
-from am4.utils.route import AircraftRoute, Route, RoutesSearch, SameOdException
+from am4.utils.route import (
+    AircraftRoute,
+    AircraftSearch,
+    CancellationToken,
+    DemandOverlay,
+    InvalidFilterException,
+    Route,
+    RoutesSearch,
+    SameOdException,
+)
 
 
 def test_route():
@@ -327,3 +337,324 @@ def test_export_routes_vip():
 
 def test_load():
     assert AircraftRoute.estimate_load() == pytest.approx(0.7867845)
+
+
+def test_find_routes_cancelled():
+    ap0 = Airport.search("VHHH").ap
+    rs = RoutesSearch(ap0, Aircraft.search("mc214").ac)
+
+    token = CancellationToken()
+    token.cancel()
+    result = rs.run(token)
+    assert token.cancelled is True
+    assert result.truncated is True
+    assert result.evaluated == 0
+    assert len(result.destinations) == 0
+
+    result = rs.run(CancellationToken(timeout=60))
+    assert result.truncated is False
+    assert len(result.destinations) == len(rs.get())
+
+
+def test_find_routes_stream():
+    ap0 = Airport.search("VHHH").ap
+    rs = RoutesSearch(ap0, Aircraft.search("mc214").ac)
+    expected = rs.get()
+
+    stream = rs.stream(top_k=5)
+    streamed = [d for chunk in stream for d in chunk]
+    assert stream.done is True
+    assert stream.evaluated == stream.total == len(rs.candidates())
+    assert len(streamed) == len(expected)
+    assert [d.airport.id for d in stream.top()] == [d.airport.id for d in expected[:5]]
+
+    chunks = []
+    result = rs.run(CancellationToken(), on_chunk=chunks.append)
+    assert sum(len(c) for c in chunks) == len(result.destinations)
+
+
+@pytest.mark.parametrize(
+    "ac_name,sort_by,realism",
+    [
+        ("b744", AircraftRoute.Options.SortBy.PER_TRIP, False),
+        ("b744", AircraftRoute.Options.SortBy.PER_AC_PER_DAY, False),
+        ("mc214", AircraftRoute.Options.SortBy.PER_TRIP, True),
+        ("b744f", AircraftRoute.Options.SortBy.PER_AC_PER_DAY, False),
+        ("a32vip", AircraftRoute.Options.SortBy.PER_TRIP, False),
+        ("b744", AircraftRoute.Options.SortBy.PER_FLIGHT_HOUR, True),
+        ("b744f", AircraftRoute.Options.SortBy.INCOME, False),
+        ("mc214", AircraftRoute.Options.SortBy.PER_DAY_AFTER_HUB_COST, False),
+        ("b744", AircraftRoute.Options.SortBy.CONTRIBUTION_PER_DAY, False),
+        ("a388", AircraftRoute.Options.SortBy.PER_SEAT, False),
+    ],
+)
+def test_find_routes_top_k(ac_name: str, sort_by: AircraftRoute.Options.SortBy, realism: bool):
+    ap0 = Airport.search("VHHH").ap
+    rs = RoutesSearch(
+        ap0, Aircraft.search(ac_name).ac, AircraftRoute.Options(sort_by=sort_by), User.Default(realism=realism)
+    )
+    expected = rs.get()
+    for k in (1, 10, 50):
+        assert [d.airport.id for d in rs.top_k(k)] == [d.airport.id for d in expected[:k]]
+
+
+def test_find_routes_distance_window():
+    ap0 = Airport.search("VHHH").ap
+    ac = Aircraft.search("b744").ac
+    full = RoutesSearch(ap0, ac)
+    window = RoutesSearch(ap0, ac, AircraftRoute.Options(min_distance=3000, max_distance=6000))
+    assert len(window.candidates()) < len(full.candidates())
+
+    expected = [d.airport.id for d in full.get() if 3000 <= d.ac_route.route.direct_distance <= 6000]
+    assert [d.airport.id for d in window.get()] == expected
+
+
+def test_route_below_min_distance():
+    ap0 = Airport.search("VHHH").ap
+    ap1 = Airport.search("RCTP").ap
+    r = AircraftRoute.create(ap0, ap1, Aircraft.search("b744").ac, AircraftRoute.Options(min_distance=3000))
+    assert r.valid is False
+    assert AircraftRoute.Warning.ERR_DISTANCE_BELOW_SPECIFIED in r.warnings
+
+
+def test_find_routes_filter():
+    ap0 = Airport.search("VHHH").ap
+    ac = Aircraft.search("b744").ac
+    full = RoutesSearch(ap0, ac).get()
+    excluded = [d.airport.id for d in full[:3]]
+
+    f = RoutesSearch.Filter.parse(
+        f"continent={ap0.continent.lower()}; market>=60; rwy>=10000; exclude={','.join(map(str, excluded))}"
+    )
+    assert f.min_market == 60 and f.min_rwy == 10000 and f.exclude_ids == excluded
+    filtered = RoutesSearch(ap0, ac, filter=f).get()
+    expected = [
+        d.airport.id
+        for d in full
+        if d.airport.continent == ap0.continent
+        and d.airport.market >= 60
+        and d.airport.rwy >= 10000
+        and d.airport.id not in excluded
+    ]
+    assert 0 < len(filtered) < len(full)
+    assert [d.airport.id for d in filtered] == expected
+    assert RoutesSearch.Filter().empty() is True
+
+
+@pytest.mark.parametrize("expr", ["market>60", "rwy>=ten", "altitude>=3", "continent", "hub_cost<=1,2"])
+def test_filter_invalid(expr: str):
+    with pytest.raises(InvalidFilterException):
+        RoutesSearch.Filter.parse(expr)
+
+
+def test_find_routes_then_by():
+    SortBy = AircraftRoute.Options.SortBy
+    ap0 = Airport.search("VHHH").ap
+    ac = Aircraft.search("b744").ac
+    rs = RoutesSearch(ap0, ac, AircraftRoute.Options(sort_by=SortBy.CONTRIBUTION_PER_DAY, then_by=[SortBy.INCOME]))
+    dests = rs.get()
+    keys = [
+        (-d.ac_route.contribution * d.ac_route.trips_per_day_per_ac, -d.ac_route.income, d.airport.id) for d in dests
+    ]
+    assert keys == sorted(keys)
+    assert [d.airport.id for d in rs.top_k(20)] == [d.airport.id for d in dests[:20]]
+
+
+def test_find_routes_pareto():
+    SortBy = AircraftRoute.Options.SortBy
+    ap0 = Airport.search("VHHH").ap
+    rs = RoutesSearch(ap0, Aircraft.search("b744").ac, user=User.Default(realism=True))
+    result = rs.pareto([SortBy.PER_AC_PER_DAY, SortBy.CONTRIBUTION_PER_DAY, SortBy.FLIGHT_TIME])
+    assert result.truncated is False
+    assert result.evaluated == len(rs.candidates())
+
+    def objectives(d):
+        r = d.ac_route
+        return (r.profit * r.trips_per_day_per_ac, r.contribution * r.trips_per_day_per_ac, -r.flight_time)
+
+    def dominates(a, b):
+        return all(x >= y for x, y in zip(a, b)) and a != b
+
+    everything = [objectives(d) for d in rs.get()]
+    frontier = [objectives(d) for d in result.destinations]
+    expected = [p for p in everything if not any(dominates(q, p) for q in everything)]
+    assert 0 < len(frontier) < len(everything)
+    assert frontier == expected
+
+    with pytest.raises(ValueError):
+        rs.pareto([])
+
+
+@pytest.mark.parametrize("ac_name", ["b744", "b744f", "a32vip"])
+def test_tpd_curve(ac_name: str):
+    ap0 = Airport.search("VHHH").ap
+    ap1 = Airport.search("TPE").ap
+    ac = Aircraft.search(ac_name).ac
+    r = AircraftRoute.create(ap0, ap1, ac)
+    curve = AircraftRoute.tpd_curve(r, ac)
+    assert [p.trips_per_day_per_ac for p in curve] == list(range(1, len(curve) + 1))
+    assert len(curve) >= r.trips_per_day_per_ac
+
+    # the AUTO sweep picks one of the points on the curve
+    picked = curve[r.trips_per_day_per_ac - 1]
+    assert picked.num_ac == r.num_ac
+    assert picked.income == pytest.approx(r.income)
+    assert picked.profit == pytest.approx(r.profit)
+
+    for p in curve[:3]:
+        options = AircraftRoute.Options(
+            tpd_mode=AircraftRoute.Options.TPDMode.STRICT_ALLOW_MULTIPLE_AC, trips_per_day_per_ac=p.trips_per_day_per_ac
+        )
+        strict = AircraftRoute.create(ap0, ap1, ac, options)
+        assert p.num_ac == strict.num_ac
+        assert p.profit == pytest.approx(strict.profit)
+
+
+@pytest.mark.parametrize("ac_name", ["a388", "b744f"])
+def test_optimise_ci(ac_name: str):
+    ap0 = Airport.search("VHHH").ap
+    ap1 = Airport.search("LHR").ap
+    ac = Aircraft.search(ac_name).ac
+    r = AircraftRoute.create(ap0, ap1, ac)
+    assert r.ci == 200
+
+    CIObjective = AircraftRoute.Options.CIObjective
+    by_profit = AircraftRoute.create(ap0, ap1, ac, AircraftRoute.Options(ci_objective=CIObjective.PER_AC_PER_DAY))
+    assert by_profit.valid
+    assert 0 <= by_profit.ci <= 200
+    assert by_profit.profit * by_profit.trips_per_day_per_ac >= r.profit * r.trips_per_day_per_ac
+    assert by_profit.fuel <= r.fuel
+    assert by_profit.flight_time >= r.flight_time
+    assert by_profit.flight_time * by_profit.trips_per_day_per_ac <= 24
+
+    by_contribution = AircraftRoute.create(
+        ap0, ap1, ac, AircraftRoute.Options(ci_objective=CIObjective.CONTRIBUTION_PER_DAY)
+    )
+    assert (
+        by_contribution.contribution * by_contribution.trips_per_day_per_ac
+        >= r.contribution * r.trips_per_day_per_ac - 1e-3
+    )
+
+    # the fixed tpd of the strict modes is kept
+    options = AircraftRoute.Options(
+        tpd_mode=AircraftRoute.Options.TPDMode.STRICT,
+        trips_per_day_per_ac=1,
+        ci_objective=CIObjective.PER_AC_PER_DAY,
+    )
+    strict = AircraftRoute.create(ap0, ap1, ac, options)
+    options.ci_objective = CIObjective.NONE
+    baseline = AircraftRoute.create(ap0, ap1, ac, options)
+    assert strict.trips_per_day_per_ac == 1
+    assert strict.flight_time <= 24
+    assert strict.profit >= baseline.profit
+
+
+def test_aircraft_search():
+    SortBy = AircraftRoute.Options.SortBy
+    ap0 = Airport.search("VHHH").ap
+    ap1 = Airport.search("LHR").ap
+    options = AircraftRoute.Options(sort_by=SortBy.PER_AC_PER_DAY)
+    candidates = AircraftSearch(ap0, ap1, options).top_k(20)
+    assert len(candidates) == 20
+    per_day = [c.ac_route.profit * c.ac_route.trips_per_day_per_ac for c in candidates]
+    assert per_day == sorted(per_day, reverse=True)
+
+    # the shared stopovers and route give the same result as evaluating each aircraft on its own
+    for c in candidates:
+        r = AircraftRoute.create(ap0, ap1, c.aircraft, options)
+        assert r.valid
+        assert r.profit == pytest.approx(c.ac_route.profit)
+        assert r.stopover.exists == c.ac_route.stopover.exists
+        if r.stopover.exists:
+            assert r.stopover.airport.id == c.ac_route.stopover.airport.id
+
+    everything = AircraftSearch(ap0, ap1, options, include_mods=False, threads=1).top_k(0)
+    assert not any(c.aircraft.speed_mod or c.aircraft.fuel_mod or c.aircraft.co2_mod for c in everything)
+    assert all(c.ac_route.valid for c in everything)
+    best = candidates[0].ac_route.profit * candidates[0].ac_route.trips_per_day_per_ac
+    assert everything[0].ac_route.profit * everything[0].ac_route.trips_per_day_per_ac <= best
+
+
+def test_demand_overlay():
+    ap0 = Airport.search("VHHH").ap
+    ap1 = Airport.search("TPE").ap
+    ac = Aircraft.search("b744").ac
+    full = AircraftRoute.create(ap0, ap1, ac).route.pax_demand
+
+    overlay = DemandOverlay()
+    overlay.consume(ap0, ap1, PaxDemand(full.y // 2, 0, 0))
+    overlay.consume(ap1, ap0, PaxDemand(0, full.j + 100, 0))  # same pair, the other way round
+    assert len(overlay) == 1
+    r = AircraftRoute.create(ap0, ap1, ac, AircraftRoute.Options(demand_overlay=overlay))
+    assert r.route.pax_demand.y == full.y - full.y // 2
+    assert r.route.pax_demand.j == 0
+    assert r.route.pax_demand.f == full.f
+
+    # the best destination is no longer worth flying once its demand is taken
+    options = AircraftRoute.Options(sort_by=AircraftRoute.Options.SortBy.PER_AC_PER_DAY)
+    best = RoutesSearch(ap0, ac, options).get()[0].airport
+    options.demand_overlay.consume(ap0, best, PaxDemand(65535, 65535, 65535))
+    dests = RoutesSearch(ap0, ac, options).get()
+    assert best.id not in [d.airport.id for d in dests]
+    assert not AircraftRoute.create(ap0, best, ac, options).valid
+
+
+def test_demand_provider():
+    provider = DemandProvider.Default()
+    ap0 = Airport.search("VHHH").ap
+    ap1 = Airport.search("TPE").ap
+    ap2 = Airport.search("LHR").ap
+    ac = Aircraft.search("b744").ac
+
+    provider.set("test-user", ap0, ap1, PaxDemand(100, 10, 1))
+    layer = provider.layer("test-user")
+    assert layer.key == "test-user"
+    assert len(layer) == 1
+    options = AircraftRoute.Options()
+    options.demand_layer = layer
+    d = AircraftRoute.create(ap1, ap0, ac, options).route.pax_demand
+    assert (d.y, d.j, d.f) == (100, 10, 1)
+    # pairs without an override read the base layer
+    assert (
+        AircraftRoute.create(ap0, ap2, ac, options).route.pax_demand.y
+        == AircraftRoute.create(ap0, ap2, ac).route.pax_demand.y
+    )
+
+    # a published layer never changes: searches holding it are unaffected by later writes
+    provider.set("test-user", ap0, ap1, PaxDemand(200, 20, 2))
+    assert AircraftRoute.create(ap0, ap1, ac, options).route.pax_demand.y == 100
+    assert provider.layer("test-user").version > layer.version
+
+    assert provider.erase("test-user")
+    assert provider.layer("test-user") is None
+
+
+def test_lazy_demand():
+    provider = DemandProvider.Default()
+    ap0 = Airport.search("VHHH").ap
+    ap1 = Airport.search("TPE").ap
+    ap2 = Airport.search("LHR").ap
+    ac = Aircraft.search("b744").ac
+    eager = AircraftRoute.create(ap0, ap1, ac).route.pax_demand
+    assert provider.blocks is None
+
+    init(lazy_demand=True, demand_cache_bytes=2 * DemandBlockCache.BLOCK_BYTES)
+    try:
+        blocks = provider.blocks
+        assert blocks.max_blocks == 2
+        assert not blocks.contains(ap0)
+        d = AircraftRoute.create(ap0, ap1, ac).route.pax_demand
+        assert (d.y, d.j, d.f) == (eager.y, eager.j, eager.f)
+        # the pair is in the block of either airport
+        d = AircraftRoute.create(ap1, ap0, ac).route.pax_demand
+        assert (d.y, d.j, d.f) == (eager.y, eager.j, eager.f)
+        stats = blocks.stats()
+        assert stats.faults == 2
+        assert stats.bytes == 2 * DemandBlockCache.BLOCK_BYTES
+
+        assert blocks.warm_up([ap2, ap1]) == 1
+        assert blocks.contains(ap2)
+        assert not blocks.contains(ap0)  # least recently used
+        assert blocks.stats().evictions == 1
+    finally:
+        init()
@@ -0,0 +1,79 @@
+from concurrent.futures import ThreadPoolExecutor
+
+import pytest
+
+from am4.utils.aircraft import Aircraft
+from am4.utils.airport import Airport
+from am4.utils.route import AircraftRoute, RoutesSearch
+from am4.utils.scheduler import Scheduler, SchedulerRejectedException
+
+
+def test_scheduler_submit():
+    ap0 = Airport.search("VHHH").ap
+    ac = Aircraft.search("mc214").ac
+    rs = RoutesSearch(ap0, ac)
+    scheduler = Scheduler(max_concurrency=2)
+    result = scheduler.submit(rs, Scheduler.Priority.BATCH)
+    assert result.truncated is False
+    assert len(result.destinations) == len(rs.get())
+
+    stats = scheduler.stats()
+    assert stats.completed[Scheduler.Priority.BATCH.value] == 1
+    assert stats.queued == [0, 0, 0]
+    assert stats.running == [0, 0, 0]
+    assert scheduler.class_limits[Scheduler.Priority.BATCH.value] == 1
+
+
+def test_scheduler_estimate_cost():
+    ap0 = Airport.search("VHHH").ap
+    short = RoutesSearch(ap0, Aircraft.search("c172").ac)
+    long = RoutesSearch(ap0, Aircraft.search("b744").ac)
+    constrained = RoutesSearch(ap0, Aircraft.search("b744").ac, AircraftRoute.Options(max_distance=3000))
+    assert Scheduler.estimate_cost(short) < Scheduler.estimate_cost(constrained) < Scheduler.estimate_cost(long)
+
+
+def test_scheduler_rejects_impossible_deadline():
+    ap0 = Airport.search("VHHH").ap
+    rs = RoutesSearch(ap0, Aircraft.search("b744").ac)
+    scheduler = Scheduler()
+    with pytest.raises(SchedulerRejectedException):
+        scheduler.submit(rs, Scheduler.Priority.API, timeout=0)
+    assert scheduler.stats().rejected[Scheduler.Priority.API.value] == 1
+
+
+def test_scheduler_coalesces_identical_searches():
+    ap0 = Airport.search("VHHH").ap
+    scheduler = Scheduler(max_concurrency=4)
+    searches = [RoutesSearch(ap0, Aircraft.search("b744").ac) for _ in range(4)]
+    with ThreadPoolExecutor(max_workers=4) as executor:
+        results = list(executor.map(lambda rs: scheduler.submit(rs, Scheduler.Priority.API), searches))
+
+    assert len({len(r.destinations) for r in results}) == 1
+    stats = scheduler.stats()
+    api = Scheduler.Priority.API.value
+    assert stats.completed[api] >= 1
+    assert stats.completed[api] + stats.coalesced[api] == 4
+
+
+def test_scheduler_follower_outlives_rejected_leader():
+    ap0 = Airport.search("VHHH").ap
+    ac = Aircraft.search("b744").ac
+    expected = len(RoutesSearch(ap0, ac).get())
+    scheduler = Scheduler(max_concurrency=1)
+
+    def batch_leader():
+        try:
+            scheduler.submit(RoutesSearch(ap0, ac), Scheduler.Priority.BATCH, timeout=1e-3)
+        except SchedulerRejectedException:
+            pass
+
+    # neither the interactive request nor a batch one without a deadline may inherit the leader's rejection
+    with ThreadPoolExecutor(max_workers=3) as executor:
+        executor.submit(batch_leader)
+        interactive = executor.submit(scheduler.submit, RoutesSearch(ap0, ac), Scheduler.Priority.INTERACTIVE)
+        batch = executor.submit(scheduler.submit, RoutesSearch(ap0, ac), Scheduler.Priority.BATCH)
+        for result in (interactive.result(), batch.result()):
+            assert result.truncated is False
+            assert len(result.destinations) == expected
+    # the interactive request never waits on the batch search
+    assert scheduler.stats().coalesced[Scheduler.Priority.INTERACTIVE.value] == 0
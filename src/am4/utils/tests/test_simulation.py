@@ -0,0 +1,95 @@
+import pytest
+
+from am4.utils.aircraft import Aircraft
+from am4.utils.airport import Airport
+from am4.utils.game import Campaign, User
+from am4.utils.route import AircraftRoute, RoutesSearch
+from am4.utils.simulation import CampaignPlanner, LoadSimulation
+
+ap0 = Airport.search("VHHH").ap
+ap1 = Airport.search("LHR").ap
+ac = Aircraft.search("b744").ac
+# low enough that a load is rarely cut off at 100%
+user = User.Default()
+user.load = 0.87
+
+
+def test_load_simulation_bands():
+    ar = AircraftRoute.create(ap0, ap1, ac, user=user)
+    r = LoadSimulation(samples=2000).run(ar, ac, user, stream=ap1.id)
+    n = ar.trips_per_day_per_ac * ar.num_ac
+
+    assert r.flights_per_day == n
+    assert r.mean_load == pytest.approx(0.87)
+    assert r.load.p10 < r.load.p50 < r.load.p90 <= 1
+    assert r.load.mean == pytest.approx(0.87, rel=0.01)
+    # loads above the one the config was solved for run into the demand
+    assert r.income.p10 < r.income.p50 <= r.income.p90
+    assert r.profit.p10 < r.profit.p50 <= r.profit.p90
+    # centred on the point estimate, which flies every trip at the mean load
+    assert r.income.p50 == pytest.approx(ar.income * n, rel=0.02)
+    assert r.profit.p50 == pytest.approx(ar.profit * n, rel=0.05)
+
+
+def test_load_simulation_distributions():
+    ar = AircraftRoute.create(ap0, ap1, ac, user=user)
+    normal = LoadSimulation(autoprice_ratio=1.1).run(ar, ac, user)
+    uniform = LoadSimulation(autoprice_ratio=1.0).run(ar, ac, user)
+    # a uniform load within 5.2% of the mean spreads less than a normal one with 6.8% of it as the deviation
+    assert uniform.load.p90 - uniform.load.p10 < normal.load.p90 - normal.load.p10
+
+    with_rep = LoadSimulation(reputation=60).run(ar, ac, user)
+    assert with_rep.mean_load == pytest.approx(AircraftRoute.estimate_load(60, 1.06, ar.stopover.exists))
+
+
+def test_load_simulation_reproducible():
+    ar = AircraftRoute.create(ap0, ap1, ac)
+    a = LoadSimulation(seed=42, threads=1).run(ar, ac, stream=7).to_dict()
+    b = LoadSimulation(seed=42, threads=8).run(ar, ac, stream=7).to_dict()
+    assert a == b
+    assert LoadSimulation(seed=43).run(ar, ac, stream=7).to_dict() != a
+
+
+def test_load_simulation_top_k():
+    rs = RoutesSearch(ap0, ac, user=user)
+    sim = LoadSimulation(samples=500, seed=1)
+    top = sim.top_k(rs, 5)
+    expected = rs.top_k(5)
+    assert [d.airport.id for d, _ in top] == [d.airport.id for d in expected]
+    for d, r in top:
+        assert r.profit.p10 <= r.profit.p50 <= r.profit.p90
+        assert r.to_dict() == sim.run(d.ac_route, ac, user, stream=d.airport.id).to_dict()
+
+
+def test_load_terms_capped_by_demand():
+    ar = AircraftRoute.create(ap0, ap1, ac, user=user)
+    terms = AircraftRoute.LoadTerms.of(ar, ac, user)
+    assert terms.flights_per_day == ar.trips_per_day_per_ac * ar.num_ac
+    assert terms.income(user.load) == pytest.approx(ar.income)
+    assert terms.income(0.5) < terms.income(user.load) <= terms.income(2.0)
+    assert terms.profit(user.load) < terms.income(user.load)
+
+
+def test_campaign_planner():
+    destinations = RoutesSearch(ap0, ac, user=user).get()[:20]
+    planner = CampaignPlanner(destinations, ac, user)
+    assert planner.planes >= sum(d.ac_route.num_ac for d in destinations)
+    # a pax only network: no, c1 .. c4 without eco, and every tier with it
+    assert len(planner.candidates()) == 9
+
+    none = planner.evaluate(Campaign())
+    assert none.gain == 0 and none.cost == 0
+    assert none.pax_reputation == planner.base_reputation
+
+    c1 = planner.evaluate(Campaign.parse("c1"))
+    c4 = planner.evaluate(Campaign.parse("c4"))
+    assert 0 < c1.gain < c4.gain
+    assert c1.pax_reputation < c4.pax_reputation
+
+    ranked = planner.rank()
+    assert len(ranked) == 9
+    assert all(a.net >= b.net for a, b in zip(ranked, ranked[1:]))
+    assert ranked[0].to_dict()["net"] == ranked[0].net
+
+    with pytest.raises(ValueError):
+        planner.candidates(0)
@@ -0,0 +1,85 @@
+import pytest
+
+from am4.utils.aircraft import Aircraft
+from am4.utils.airport import Airport
+from am4.utils.game import User
+from am4.utils.route import AircraftRoute, CancellationToken, RoutesSearch
+from am4.utils.store import CursorNotFoundException, ResultStore
+
+
+def test_store_pages():
+    ap0 = Airport.search("VHHH").ap
+    rs = RoutesSearch(ap0, Aircraft.search("b744").ac)
+    expected = rs.get()
+    store = ResultStore(capacity=4)
+
+    first = store.search(rs, limit=20)
+    assert first.total == len(expected)
+    assert first.has_more is True
+    assert [d.airport.id for d in first.destinations] == [d.airport.id for d in expected[:20]]
+
+    second = store.page(first.cursor, offset=20, limit=20)
+    assert second.offset == 20
+    assert [d.airport.id for d in second.destinations] == [d.airport.id for d in expected[20:40]]
+
+    last = store.page(first.cursor, offset=first.total - 5, limit=20)
+    assert len(last.destinations) == 5
+    assert last.has_more is False
+
+
+def test_store_resort():
+    ap0 = Airport.search("VHHH").ap
+    rs = RoutesSearch(ap0, Aircraft.search("b744").ac)
+    store = ResultStore()
+    cursor = store.search(rs, limit=0).cursor
+
+    page = store.page(cursor, limit=50, sort_by=AircraftRoute.Options.SortBy.PER_AC_PER_DAY)
+    per_day = [d.ac_route.profit * d.ac_route.trips_per_day_per_ac for d in page.destinations]
+    assert per_day == sorted(per_day, reverse=True)
+
+    # rows that tie under the new key keep one order, so consecutive pages neither repeat nor skip a row
+    by = AircraftRoute.Options.SortBy.PER_AC_PER_DAY
+    whole = store.page(cursor, limit=100, sort_by=by)
+    halves = store.page(cursor, limit=50, sort_by=by).destinations + store.page(cursor, 50, 50, by).destinations
+    assert [d.airport.id for d in halves] == [d.airport.id for d in whole.destinations]
+
+
+def test_store_reprice():
+    ap0 = Airport.search("VHHH").ap
+    ac = Aircraft.search("b744").ac
+    rs = RoutesSearch(ap0, ac)
+    store = ResultStore()
+    cursor = store.search(rs, limit=0).cursor
+
+    user = User.Default()
+    user.fuel_price = 1500
+    user.co2_price = 180
+    expected = RoutesSearch(ap0, ac, user=user).get()
+    assert rs.reprice(rs.get(), 1500, 180)[0].airport.id == expected[0].airport.id
+
+    store.reprice(cursor, fuel_price=1500, co2_price=180)
+    page = store.page(cursor, limit=50)
+    assert [d.airport.id for d in page.destinations] == [d.airport.id for d in expected[:50]]
+    assert [d.ac_route.profit for d in page.destinations] == pytest.approx([d.ac_route.profit for d in expected[:50]])
+
+    with pytest.raises(CursorNotFoundException):
+        store.reprice("0000000000000000", fuel_price=500)
+
+
+def test_store_evicts_least_recently_used():
+    ap0 = Airport.search("VHHH").ap
+    rs = RoutesSearch(ap0, Aircraft.search("mc214").ac)
+    result = rs.run(CancellationToken())
+    store = ResultStore(capacity=2)
+    c0 = store.put(rs, result)
+    c1 = store.put(rs, result)
+    store.page(c0)  # c0 is now the most recently used
+    c2 = store.put(rs, result)
+
+    assert len(store) == 2
+    store.page(c0)
+    store.page(c2)
+    with pytest.raises(CursorNotFoundException):
+        store.page(c1)
+    assert store.erase(c0) is True
+    assert store.erase(c0) is False